@@ -69,11 +69,26 @@ void handleLobbyData(int clientSocket) {
     std::cout << "\nВведите название лобби: ";
     std::string lobbyname;
     std::getline(std::cin, lobbyname);
-    std::cout << "Введите пароль лобби: ";
+    std::cout << "Введите пароль лобби (Enter - без пароля): ";
     std::string password;
     std::getline(std::cin, password);
 
-    std::string message = lobbyname + " " + password;
+    std::string message = password.empty() ? lobbyname : lobbyname + " " + password;
+    send(clientSocket, message.c_str(), message.size(), 0);
+}
+
+void handleLobbyFilter(int clientSocket) {
+    std::cout << "\nНачало названия (Enter - все): ";
+    std::string prefix;
+    std::getline(std::cin, prefix);
+    std::cout << "Размер доски (Enter - любой): ";
+    std::string boardSize;
+    std::getline(std::cin, boardSize);
+    std::cout << "С паролем? (да/нет, Enter - неважно): ";
+    std::string password;
+    std::getline(std::cin, password);
+
+    std::string message = prefix + ";" + boardSize + ";" + password;
     send(clientSocket, message.c_str(), message.size(), 0);
 }
 
@@ -124,9 +139,11 @@ int main(int argc, char* argv[]) {
         {"Ваш ход. Введите номер клетки (1-9): ", handleMove},
         {"Хотите сыграть еще раз? (да/нет): ", handlePlayAgain},
         {"Выберите действие: 1 - Регистрация, 2 - Вход: ", handleAuthenticationChoice},
-        {"Хотите создать лобби или присоединиться? (1 - Создать, 2 - Присоединиться, 3 - Выход): ", handleLobbyChoice},
+        {"Хотите создать лобби или присоединиться? (1 - Создать, 2 - Присоединиться, 3 - Выход, 4 - Игра с ботом, 5 - Список лобби): ", handleLobbyChoice},
         {"Введите данные аккаунта:", handleAccountData},
         {"Введите данные лобби:", handleLobbyData},
+        {"Введите фильтр лобби:", handleLobbyFilter},
+        {"Следующая страница? (да/нет): ", handlePlayAgain},
         {"Некорректный ввод, попробуйте снова.", handleMove},
     };
 
@@ -0,0 +1,126 @@
+#include "admission.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+bool TokenBucket::take(double capacity, double refillPerSecond, std::chrono::steady_clock::time_point now) {
+    double elapsed = std::chrono::duration<double>(now - lastRefill).count();
+    tokens = std::min(capacity, tokens + elapsed * refillPerSecond);
+    lastRefill = now;
+    if (tokens < 1.0) return false;
+    tokens -= 1.0;
+    return true;
+}
+
+TokenBucket& BucketTable::touch(uint32_t address, double capacity, std::chrono::steady_clock::time_point now, size_t maxTracked) {
+    auto it = index.find(address);
+    if (it != index.end()) {
+        recent.splice(recent.begin(), recent, it->second);
+        return it->second->second;
+    }
+
+    // Вытесненный адрес при следующем соединении получит полное ведро. Это самый давно
+    // не появлявшийся адрес, и к тому времени его ведро чаще всего уже наполнилось бы
+    if (maxTracked > 0 && index.size() >= maxTracked) {
+        index.erase(recent.back().first);
+        recent.pop_back();
+    }
+    recent.emplace_front(address, TokenBucket(capacity, now));
+    index.emplace(address, recent.begin());
+    return recent.front().second;
+}
+
+void BucketTable::clear() {
+    recent.clear();
+    index.clear();
+}
+
+AdmissionControl::AdmissionControl(const AdmissionLimits& limits) : limits(limits) {}
+
+AdmissionControl::~AdmissionControl() {
+    if (counters != &localCounters) munmap(counters, sizeof(AdmissionCounters));
+}
+
+bool AdmissionControl::shareAcrossProcesses(int processes) {
+    void* mapped = mmap(nullptr, sizeof(AdmissionCounters), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) return false;
+    counters = new (mapped) AdmissionCounters();
+    this->processes = std::max(1, processes);
+    return true;
+}
+
+void AdmissionControl::attachWorker(int index) {
+    if (index < 0 || index >= AdmissionCounters::MAX_WORKERS) return;
+    worker = &counters->workers[index];
+    worker->pid.store(getpid(), std::memory_order_relaxed);
+}
+
+void AdmissionControl::reclaimExitedWorkers() {
+    for (AdmissionCounters::Worker& other : counters->workers) {
+        int pid = other.pid.load(std::memory_order_relaxed);
+        if (pid <= 0 || &other == worker || kill(pid, 0) == 0 || errno != ESRCH) continue;
+        // Из нескольких заметивших смерть процесса слоты вернёт один
+        if (!other.pid.compare_exchange_strong(pid, 0, std::memory_order_relaxed)) continue;
+        counters->activeSessions.fetch_sub(other.activeSessions.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+void AdmissionControl::setLimits(const AdmissionLimits& limits) {
+    std::lock_guard<std::mutex> lock(bucketsMutex);
+    this->limits = limits;
+    connectBuckets.clear();
+    authBuckets.clear();
+}
+
+bool AdmissionControl::takeToken(BucketTable& buckets, uint32_t address, double capacity, double refillPerSecond) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(bucketsMutex);
+    // Вёдра у каждого процесса свои: его доля - 1/processes от общего лимита
+    capacity = std::max(1.0, capacity / processes);
+    refillPerSecond /= processes;
+    return buckets.touch(address, capacity, now, limits.maxTrackedAddresses).take(capacity, refillPerSecond, now);
+}
+
+AdmissionControl::Decision AdmissionControl::admitConnection(uint32_t address) {
+    if (!takeToken(connectBuckets, address, limits.connectBurst, limits.connectPerSecond)) {
+        counters->rejectedConnectRate.fetch_add(1, std::memory_order_relaxed);
+        return REJECT_RATE;
+    }
+
+    int current = counters->activeSessions.load(std::memory_order_relaxed);
+    do {
+        if (current >= limits.maxSessions) {
+            counters->rejectedBusy.fetch_add(1, std::memory_order_relaxed);
+            return REJECT_BUSY;
+        }
+    } while (!counters->activeSessions.compare_exchange_weak(current, current + 1, std::memory_order_relaxed));
+    if (worker) worker->activeSessions.fetch_add(1, std::memory_order_relaxed);
+
+    counters->accepted.fetch_add(1, std::memory_order_relaxed);
+    return ADMIT;
+}
+
+void AdmissionControl::releaseSession() {
+    if (worker) worker->activeSessions.fetch_sub(1, std::memory_order_relaxed);
+    counters->activeSessions.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool AdmissionControl::allowAuthAttempt(uint32_t address) {
+    if (takeToken(authBuckets, address, limits.authBurst, limits.authPerSecond)) return true;
+    counters->rejectedAuthRate.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+AdmissionStats AdmissionControl::stats() const {
+    return {
+        counters->accepted.load(std::memory_order_relaxed),
+        counters->rejectedBusy.load(std::memory_order_relaxed),
+        counters->rejectedConnectRate.load(std::memory_order_relaxed),
+        counters->rejectedAuthRate.load(std::memory_order_relaxed),
+        counters->activeSessions.load(std::memory_order_relaxed)
+    };
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+// Ведро токенов: capacity - допустимый всплеск, refillPerSecond - средняя скорость
+struct TokenBucket {
+    double tokens;
+    std::chrono::steady_clock::time_point lastRefill;
+
+    TokenBucket(double capacity, std::chrono::steady_clock::time_point now) : tokens(capacity), lastRefill(now) {}
+
+    bool take(double capacity, double refillPerSecond, std::chrono::steady_clock::time_point now);
+};
+
+// Вёдра по адресам в порядке последнего обращения. При заполнении вытесняется самое давнее:
+// поток уникальных адресов обходится O(1) на соединение, без обхода таблицы под мьютексом
+class BucketTable {
+public:
+    TokenBucket& touch(uint32_t address, double capacity, std::chrono::steady_clock::time_point now, size_t maxTracked);
+    void clear();
+    size_t size() const { return index.size(); }
+
+private:
+    using Entry = std::pair<uint32_t, TokenBucket>;
+    std::list<Entry> recent; // в начале - недавно использованные
+    std::unordered_map<uint32_t, std::list<Entry>::iterator> index;
+};
+
+struct AdmissionLimits {
+    int maxSessions = 1000;            // одновременно обслуживаемых соединений
+    double connectBurst = 20;          // соединений с одного IP подряд
+    double connectPerSecond = 5;
+    double authBurst = 5;              // попыток регистрации/входа с одного IP подряд
+    double authPerSecond = 0.2;
+    size_t maxTrackedAddresses = 100000;
+};
+
+struct AdmissionStats {
+    uint64_t accepted;
+    uint64_t rejectedBusy;
+    uint64_t rejectedConnectRate;
+    uint64_t rejectedAuthRate;
+    int activeSessions;
+};
+
+// Счётчики допуска. При нескольких процессах-воркерах лежат в общей памяти: лимит
+// одновременных сессий и статистика общие на весь сервер
+struct AdmissionCounters {
+    static const int MAX_WORKERS = 256;
+
+    std::atomic<int> activeSessions{0};
+    std::atomic<uint64_t> accepted{0};
+    std::atomic<uint64_t> rejectedBusy{0};
+    std::atomic<uint64_t> rejectedConnectRate{0};
+    std::atomic<uint64_t> rejectedAuthRate{0};
+
+    // Сессии по процессам: слоты умершего процесса возвращает любой другой
+    struct Worker {
+        std::atomic<int> pid{0};
+        std::atomic<int> activeSessions{0};
+    };
+    Worker workers[MAX_WORKERS];
+};
+
+// Контроль допуска: решает на этапе accept, обслуживать ли соединение,
+// и ограничивает число попыток авторизации с одного адреса
+class AdmissionControl {
+public:
+    enum Decision { ADMIT, REJECT_BUSY, REJECT_RATE };
+
+    explicit AdmissionControl(const AdmissionLimits& limits = AdmissionLimits());
+    ~AdmissionControl();
+
+    // Меняет лимиты до начала обслуживания (симуляция гоняет все сессии с одного адреса)
+    void setLimits(const AdmissionLimits& limits);
+
+    // Вызывается до fork: счётчики переезжают в общую память. Вёдра адресов остаются у каждого
+    // процесса своими, поэтому их всплеск и скорость делятся на число процессов - соединение
+    // достаётся тому, чей poll успел первым, и с одного адреса в сумме проходит не больше лимита
+    // (но не меньше одного соединения на процесс при всплеске)
+    bool shareAcrossProcesses(int processes);
+    // Вызывается в каждом процессе после fork
+    void attachWorker(int index);
+    // Возвращает слоты сессий процессов, завершившихся не освободив их
+    void reclaimExitedWorkers();
+
+    // При ADMIT занимает слот сессии, который нужно вернуть через releaseSession
+    Decision admitConnection(uint32_t address);
+    void releaseSession();
+    bool allowAuthAttempt(uint32_t address);
+
+    AdmissionStats stats() const;
+
+private:
+    bool takeToken(BucketTable& buckets, uint32_t address, double capacity, double refillPerSecond);
+
+    AdmissionLimits limits;
+    std::mutex bucketsMutex;
+    BucketTable connectBuckets;
+    BucketTable authBuckets;
+    int processes = 1;
+
+    AdmissionCounters localCounters;
+    AdmissionCounters* counters = &localCounters;
+    AdmissionCounters::Worker* worker = nullptr;
+};
+
+// Возвращает слот сессии при выходе из потока клиента
+class SessionSlot {
+public:
+    explicit SessionSlot(AdmissionControl& admission) : admission(admission) {}
+    ~SessionSlot() {
+        if (attached) admission.releaseSession();
+    }
+    SessionSlot(const SessionSlot&) = delete;
+    SessionSlot& operator=(const SessionSlot&) = delete;
+
+    // Слот переходит к тому, кто дальше обслуживает соединение, и вернёт его сам
+    void detach() { attached = false; }
+    void attach() { attached = true; }
+
+private:
+    AdmissionControl& admission;
+    bool attached = true;
+};
@@ -0,0 +1,348 @@
+#include "ai.h"
+
+#include <algorithm>
+#include <thread>
+
+const int WIN_SCORE = 1000000;
+const int MATE_BOUND = WIN_SCORE - 10000;
+const int INF_SCORE = WIN_SCORE + 1;
+const int NEIGHBOUR_RADIUS = 2;
+const int DIRECTIONS[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+
+int AiBoard::stonesCount() const {
+    return static_cast<int>(std::count_if(cells.begin(), cells.end(), [](int8_t cell) { return cell != 0; }));
+}
+
+bool AiBoard::isWinningMove(int move) const {
+    int player = cells[move];
+    int x = move % width;
+    int y = move / width;
+    for (auto& dir : DIRECTIONS) {
+        int length = 1;
+        for (int sign = -1; sign <= 1; sign += 2) {
+            int cx = x + sign * dir[0];
+            int cy = y + sign * dir[1];
+            while (cx >= 0 && cx < width && cy >= 0 && cy < height && cells[cy * width + cx] == player) {
+                ++length;
+                cx += sign * dir[0];
+                cy += sign * dir[1];
+            }
+        }
+        if (length >= winLength) return true;
+    }
+    return false;
+}
+
+TranspositionTable::TranspositionTable(size_t sizePowerOfTwo) : slots(new Slot[sizePowerOfTwo]), mask(sizePowerOfTwo - 1) {}
+
+bool TranspositionTable::probe(uint64_t key, Entry& entry) const {
+    const Slot& slot = slots[key & mask];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint64_t check = slot.check.load(std::memory_order_relaxed);
+    if ((check ^ data) != key || data == 0) return false;
+
+    entry.score = static_cast<int32_t>(data & 0xffffffffu);
+    entry.depth = static_cast<int>((data >> 32) & 0xff);
+    entry.bound = static_cast<Bound>((data >> 40) & 0x3);
+    entry.move = static_cast<int>((data >> 48) & 0xffff) - 1;
+    return true;
+}
+
+void TranspositionTable::store(uint64_t key, const Entry& entry) {
+    uint64_t data = static_cast<uint64_t>(static_cast<uint32_t>(entry.score))
+        | (static_cast<uint64_t>(entry.depth & 0xff) << 32)
+        | (static_cast<uint64_t>(entry.bound) << 40)
+        | (static_cast<uint64_t>(entry.move + 1) << 48);
+    Slot& slot = slots[key & mask];
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+    slot.data.store(data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i <= mask; ++i) {
+        slots[i].check.store(0, std::memory_order_relaxed);
+        slots[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+struct SearchEngine::ThreadContext {
+    AiBoard board;
+    int player;
+    uint64_t hash = 0;
+    uint64_t nodes = 0;
+    int id = 0;
+    int completedDepth = 0;
+    int bestMove = -1;
+    int bestScore = 0;
+    int iterationMove = -1;
+    // Буферы переиспользуются между узлами: аллокации в поиске упираются в общий malloc и мешают масштабированию
+    std::vector<std::vector<int>> plyMoves;
+    std::vector<std::pair<int, int>> scored;
+
+    ThreadContext(const AiBoard& board, int player) : board(board), player(player) {}
+};
+
+SearchEngine::SearchEngine(size_t ttSize) : table(ttSize) {}
+
+void SearchEngine::prepareZobrist(int cells) {
+    size_t needed = static_cast<size_t>(cells) * 2 + 1;
+    if (zobrist.size() == needed) return;
+
+    // Детерминированный splitmix64: одинаковые ключи между запусками упрощают отладку
+    zobrist.resize(needed);
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    for (auto& key : zobrist) {
+        seed += 0x9e3779b97f4a7c15ULL;
+        uint64_t z = seed;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        key = z ^ (z >> 31);
+    }
+    table.clear();
+}
+
+// Оценка угроз для клетки: насколько длинные линии игрок получит, поставив сюда камень
+int SearchEngine::threatScore(const AiBoard& board, int cell, int player) {
+    int x = cell % board.width;
+    int y = cell / board.width;
+    int score = 0;
+    for (auto& dir : DIRECTIONS) {
+        int length = 1;
+        int openEnds = 0;
+        for (int sign = -1; sign <= 1; sign += 2) {
+            int cx = x + sign * dir[0];
+            int cy = y + sign * dir[1];
+            while (cx >= 0 && cx < board.width && cy >= 0 && cy < board.height && board.cells[cy * board.width + cx] == player) {
+                ++length;
+                cx += sign * dir[0];
+                cy += sign * dir[1];
+            }
+            if (cx >= 0 && cx < board.width && cy >= 0 && cy < board.height && board.cells[cy * board.width + cx] == 0) ++openEnds;
+        }
+        if (length >= board.winLength) return 1 << 24;
+        if (openEnds == 0) continue;
+        score += (1 << std::min(2 * length, 20)) * openEnds;
+    }
+    return score;
+}
+
+// Кандидаты - только пустые клетки рядом с уже стоящими камнями, отсортированные по угрозам
+void SearchEngine::orderedMoves(ThreadContext& ctx, int ttMove, std::vector<int>& moves) const {
+    const AiBoard& board = ctx.board;
+    moves.clear();
+
+    std::vector<std::pair<int, int>>& scored = ctx.scored;
+    scored.clear();
+    bool hasStones = false;
+    for (int cell = 0; cell < board.size(); ++cell) {
+        if (board.cells[cell] != 0) {
+            hasStones = true;
+            continue;
+        }
+        int x = cell % board.width;
+        int y = cell / board.width;
+        bool near = false;
+        for (int dy = -NEIGHBOUR_RADIUS; dy <= NEIGHBOUR_RADIUS && !near; ++dy) {
+            for (int dx = -NEIGHBOUR_RADIUS; dx <= NEIGHBOUR_RADIUS; ++dx) {
+                int cx = x + dx;
+                int cy = y + dy;
+                if (cx >= 0 && cx < board.width && cy >= 0 && cy < board.height && board.cells[cy * board.width + cx] != 0) {
+                    near = true;
+                    break;
+                }
+            }
+        }
+        if (near) scored.emplace_back(0, cell);
+    }
+
+    if (!hasStones) {
+        moves.push_back((board.height / 2) * board.width + board.width / 2);
+        return;
+    }
+    if (scored.empty()) {
+        // Все соседние клетки заняты - рассматриваем оставшиеся пустые
+        for (int cell = 0; cell < board.size(); ++cell) {
+            if (board.cells[cell] == 0) scored.emplace_back(0, cell);
+        }
+    }
+
+    int opponent = 3 - ctx.player;
+    for (auto& [score, cell] : scored) {
+        // Своя атака важнее защиты: собственная победа всегда раньше блока
+        score = 2 * threatScore(board, cell, ctx.player) + threatScore(board, cell, opponent);
+        if (cell == ttMove) score = 1 << 30;
+    }
+    std::stable_sort(scored.begin(), scored.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (auto& entry : scored) moves.push_back(entry.second);
+}
+
+int SearchEngine::evaluate(const ThreadContext& ctx) const {
+    const AiBoard& board = ctx.board;
+    int k = board.winLength;
+    long long total = 0;
+    for (auto& dir : DIRECTIONS) {
+        for (int y = 0; y < board.height; ++y) {
+            int endY = y + dir[1] * (k - 1);
+            if (endY < 0 || endY >= board.height) continue;
+            for (int x = 0; x < board.width; ++x) {
+                int endX = x + dir[0] * (k - 1);
+                if (endX < 0 || endX >= board.width) continue;
+                int counts[3] = {0, 0, 0};
+                for (int i = 0; i < k; ++i) {
+                    counts[board.cells[(y + dir[1] * i) * board.width + x + dir[0] * i]]++;
+                }
+                if (counts[1] > 0 && counts[2] > 0) continue;
+                if (counts[1] + counts[2] == 0) continue;
+                int weight = 1 << std::min(3 * (counts[1] + counts[2]), 18);
+                total += counts[ctx.player] > 0 ? weight : -weight;
+            }
+        }
+    }
+    return static_cast<int>(std::clamp<long long>(total, -MATE_BOUND + 1, MATE_BOUND - 1));
+}
+
+bool SearchEngine::timeUp(ThreadContext& ctx) {
+    if ((ctx.nodes & 1023) == 0 && std::chrono::steady_clock::now() >= deadline) {
+        stop.store(true, std::memory_order_relaxed);
+    }
+    return stop.load(std::memory_order_relaxed);
+}
+
+int SearchEngine::search(ThreadContext& ctx, int depth, int alpha, int beta, int ply) {
+    ++ctx.nodes;
+    if (timeUp(ctx)) return 0;
+    if (depth == 0) return evaluate(ctx);
+
+    uint64_t key = ctx.hash;
+    int ttMove = -1;
+    TranspositionTable::Entry entry;
+    if (table.probe(key, entry)) {
+        ttMove = entry.move;
+        int score = entry.score;
+        if (score > MATE_BOUND) score -= ply;
+        else if (score < -MATE_BOUND) score += ply;
+        if (ply > 0 && entry.depth >= depth) {
+            if (entry.bound == TranspositionTable::EXACT) return score;
+            if (entry.bound == TranspositionTable::LOWER) alpha = std::max(alpha, score);
+            if (entry.bound == TranspositionTable::UPPER) beta = std::min(beta, score);
+            if (alpha >= beta) return score;
+        }
+    }
+
+    std::vector<int>& moves = ctx.plyMoves[ply];
+    orderedMoves(ctx, ttMove, moves);
+    if (moves.empty()) return 0; // доска заполнена - ничья
+
+    // Вспомогательные потоки перебирают корневые ходы в другом порядке, чтобы не дублировать работу
+    if (ply == 0 && ctx.id > 0 && moves.size() > 2) {
+        size_t shift = 1 + (ctx.id - 1) % (moves.size() - 1);
+        std::rotate(moves.begin() + 1, moves.begin() + shift, moves.end());
+    }
+
+    int originalAlpha = alpha;
+    int bestScore = -INF_SCORE;
+    int bestMove = moves[0];
+    for (size_t i = 0; i < moves.size(); ++i) {
+        int move = moves[i];
+        ctx.board.cells[move] = static_cast<int8_t>(ctx.player);
+        ctx.hash ^= zobrist[move * 2 + ctx.player - 1] ^ zobrist.back();
+
+        int score;
+        if (ctx.board.isWinningMove(move)) {
+            score = WIN_SCORE - ply;
+        } else {
+            ctx.player = 3 - ctx.player;
+            score = -search(ctx, depth - 1, -beta, -alpha, ply + 1);
+            ctx.player = 3 - ctx.player;
+        }
+
+        ctx.hash ^= zobrist[move * 2 + ctx.player - 1] ^ zobrist.back();
+        ctx.board.cells[move] = 0;
+        if (stop.load(std::memory_order_relaxed)) return 0;
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = move;
+            if (ply == 0) ctx.iterationMove = move;
+        }
+        alpha = std::max(alpha, score);
+        if (alpha >= beta) break;
+    }
+
+    TranspositionTable::Entry result;
+    result.score = bestScore > MATE_BOUND ? bestScore + ply : (bestScore < -MATE_BOUND ? bestScore - ply : bestScore);
+    result.depth = depth;
+    result.bound = bestScore <= originalAlpha ? TranspositionTable::UPPER
+        : (bestScore >= beta ? TranspositionTable::LOWER : TranspositionTable::EXACT);
+    result.move = bestMove;
+    table.store(key, result);
+    return bestScore;
+}
+
+void SearchEngine::runThread(ThreadContext& ctx, const SearchLimits& limits) {
+    int emptyCells = ctx.board.size() - ctx.board.stonesCount();
+    int maxDepth = std::min(limits.maxDepth, emptyCells);
+    ctx.plyMoves.resize(maxDepth + 1);
+    // Половина вспомогательных потоков начинает на глубину дальше - классический приём Lazy SMP
+    for (int depth = 1 + (ctx.id % 2); depth <= maxDepth; ++depth) {
+        ctx.iterationMove = -1;
+        int score = search(ctx, depth, -INF_SCORE, INF_SCORE, 0);
+        if (stop.load(std::memory_order_relaxed)) break;
+
+        ctx.completedDepth = depth;
+        ctx.bestMove = ctx.iterationMove;
+        ctx.bestScore = score;
+        if (score > MATE_BOUND || score < -MATE_BOUND) break;
+    }
+    // Главный поток закончил - остальные больше не нужны
+    if (ctx.id == 0) stop.store(true, std::memory_order_relaxed);
+}
+
+SearchResult SearchEngine::findBestMove(const AiBoard& board, int player, const SearchLimits& limits) {
+    prepareZobrist(board.size());
+    stop.store(false);
+    auto start = std::chrono::steady_clock::now();
+    deadline = start + limits.timeBudget;
+
+    uint64_t hash = player == 2 ? zobrist.back() : 0;
+    for (int cell = 0; cell < board.size(); ++cell) {
+        if (board.cells[cell] != 0) hash ^= zobrist[cell * 2 + board.cells[cell] - 1];
+    }
+
+    int threadsCount = std::max(1, limits.threads);
+    std::vector<ThreadContext> contexts;
+    contexts.reserve(threadsCount);
+    for (int i = 0; i < threadsCount; ++i) {
+        contexts.emplace_back(board, player);
+        contexts.back().id = i;
+        contexts.back().hash = hash;
+    }
+
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < threadsCount; ++i) {
+        helpers.emplace_back(&SearchEngine::runThread, this, std::ref(contexts[i]), std::cref(limits));
+    }
+    runThread(contexts[0], limits);
+    for (auto& helper : helpers) helper.join();
+
+    SearchResult result;
+    const ThreadContext* best = &contexts[0];
+    for (const auto& ctx : contexts) {
+        result.nodes += ctx.nodes;
+        if (ctx.completedDepth > best->completedDepth && ctx.bestMove >= 0) best = &ctx;
+    }
+    result.move = best->bestMove;
+    result.score = best->bestScore;
+    result.depth = best->completedDepth;
+
+    // Не успели закончить даже первую итерацию - берём лучший ход по угрозам
+    if (result.move < 0) {
+        std::vector<int> moves;
+        orderedMoves(contexts[0], -1, moves);
+        if (!moves.empty()) result.move = moves[0];
+    }
+
+    result.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (result.elapsedSeconds > 0) result.nodesPerSecond = result.nodes / result.elapsedSeconds;
+    return result;
+}
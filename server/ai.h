@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Доска N×M с условием победы "K в ряд" (3×3/3 - обычные крестики-нолики, 15×15/5 - гомоку)
+struct AiBoard {
+    int width;
+    int height;
+    int winLength;
+    std::vector<int8_t> cells; // 0 - пусто, 1 - первый игрок, 2 - второй игрок
+
+    AiBoard(int width, int height, int winLength) : width(width), height(height), winLength(winLength), cells(width * height, 0) {}
+
+    int size() const { return width * height; }
+    int stonesCount() const;
+    // Проверяет, образует ли камень в клетке move линию длины winLength
+    bool isWinningMove(int move) const;
+};
+
+struct SearchLimits {
+    int threads = 1;
+    std::chrono::milliseconds timeBudget{1000};
+    int maxDepth = 64;
+};
+
+struct SearchResult {
+    int move = -1;                 // индекс клетки, -1 если ходов нет
+    int score = 0;
+    int depth = 0;                 // глубина последней завершённой итерации
+    uint64_t nodes = 0;            // сумма по всем потокам
+    double elapsedSeconds = 0.0;
+    double nodesPerSecond = 0.0;
+};
+
+// Общая таблица транспозиций без блокировок: ключ хранится как key ^ data,
+// поэтому запись, порванная гонкой двух потоков, просто не пройдёт проверку при чтении
+class TranspositionTable {
+public:
+    enum Bound : uint8_t { EMPTY = 0, EXACT = 1, LOWER = 2, UPPER = 3 };
+
+    struct Entry {
+        int score;
+        int depth;
+        Bound bound;
+        int move;
+    };
+
+    explicit TranspositionTable(size_t sizePowerOfTwo = 1 << 20);
+
+    bool probe(uint64_t key, Entry& entry) const;
+    void store(uint64_t key, const Entry& entry);
+    void clear();
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> check{0};
+        std::atomic<uint64_t> data{0};
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+};
+
+// Параллельный поиск (Lazy SMP): все потоки углубляют итерации от одного корня
+// и обмениваются результатами только через общую таблицу транспозиций.
+// Один экземпляр не рассчитан на одновременные вызовы findBestMove из разных потоков.
+class SearchEngine {
+public:
+    explicit SearchEngine(size_t ttSize = 1 << 20);
+
+    // player - кто ходит (1 или 2)
+    SearchResult findBestMove(const AiBoard& board, int player, const SearchLimits& limits);
+
+private:
+    struct ThreadContext;
+
+    int search(ThreadContext& ctx, int depth, int alpha, int beta, int ply);
+    int evaluate(const ThreadContext& ctx) const;
+    void orderedMoves(ThreadContext& ctx, int ttMove, std::vector<int>& moves) const;
+    static int threatScore(const AiBoard& board, int cell, int player);
+    void runThread(ThreadContext& ctx, const SearchLimits& limits);
+    bool timeUp(ThreadContext& ctx);
+    void prepareZobrist(int cells);
+
+    TranspositionTable table;
+    std::vector<uint64_t> zobrist;
+    std::atomic<bool> stop{false};
+    std::chrono::steady_clock::time_point deadline;
+};
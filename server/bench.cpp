@@ -0,0 +1,427 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cstring>
+#include "bench.h"
+#include "check.h"
+#include "logger.h"
+#include "server.h"
+
+namespace {
+
+// Ход бота в позиции 3×3: бот играет за 'O', как в handleBotSession
+int botMove(SearchEngine& engine, const Board& board) {
+    AiBoard aiBoard(3, 3, 3);
+    for (int i = 0; i < 9; ++i) {
+        aiBoard.cells[i] = board[i] == 'X' ? 1 : (board[i] == 'O' ? 2 : 0);
+    }
+    return engine.findBestMove(aiBoard, 2, {1, BOT_MOVE_BUDGET, 9}).move;
+}
+
+// Перебирает все партии против бота; возвращает число партий или -1, если бот хоть раз проиграл
+int countBotGames(SearchEngine& engine, Board& board) {
+    int games = 0;
+    for (int cell = 0; cell < 9; ++cell) {
+        if (board[cell] != ' ') continue;
+        Board next = board;
+        next[cell] = 'X';
+        if (checkWin(next, 'X')) return -1;
+        if (std::count(next.begin(), next.end(), ' ') == 0) {
+            ++games;
+            continue;
+        }
+        int reply = botMove(engine, next);
+        if (reply < 0 || next[reply] != ' ') return -1;
+        next[reply] = 'O';
+        if (checkWin(next, 'O') || std::count(next.begin(), next.end(), ' ') == 0) {
+            ++games;
+            continue;
+        }
+        int subgames = countBotGames(engine, next);
+        if (subgames < 0) return -1;
+        games += subgames;
+    }
+    return games;
+}
+
+// Проверки корректности движка: бот 3×3 не проигрывает, вынужденные выигрыши и защиты находятся
+bool checkSearchEngine() {
+    CheckReport report;
+
+    SearchEngine engine(1 << 12);
+    Board empty;
+    empty.fill(' ');
+    int games = countBotGames(engine, empty);
+    report("бот 3×3 не проигрывает (партий перебрано: " + std::to_string(std::max(games, 0)) + ")", games > 0);
+
+    Board win = {'O', 'O', ' ', 'X', 'X', ' ', ' ', ' ', 'X'};
+    report("3×3: бот выигрывает, а не защищается", botMove(engine, win) == 2);
+    Board block = {'X', 'X', ' ', ' ', 'O', ' ', ' ', ' ', ' '};
+    report("3×3: бот закрывает линию соперника", botMove(engine, block) == 2);
+
+    auto at = [](int row, int column) { return row * 15 + column; };
+    AiBoard four(15, 15, 5);
+    for (int column = 5; column <= 8; ++column) four.cells[at(7, column)] = 1;
+    for (int cell : {at(0, 0), at(0, 14), at(14, 0), at(14, 14)}) four.cells[cell] = 2;
+    int move = SearchEngine().findBestMove(four, 1, {1, std::chrono::milliseconds(500), 64}).move;
+    report("15×15: открытая четвёрка доводится до пяти", move == at(7, 4) || move == at(7, 9));
+
+    AiBoard closed(15, 15, 5);
+    for (int column = 5; column <= 8; ++column) closed.cells[at(7, column)] = 1;
+    closed.cells[at(3, 3)] = 1;
+    for (int cell : {at(7, 4), at(0, 0), at(0, 14), at(14, 0)}) closed.cells[cell] = 2;
+    move = SearchEngine().findBestMove(closed, 2, {1, std::chrono::milliseconds(500), 64}).move;
+    report("15×15: закрытая четвёрка соперника блокируется", move == at(7, 9));
+
+    return report.allPassed();
+}
+
+}
+
+// Замер параллельного поиска на доске 15×15 (5 в ряд). Lazy SMP увеличивает число узлов в секунду
+// во многом за счёт повторной работы, поэтому ускорение считается по времени до одной и той же
+// глубины: сначала один поток за budget определяет достижимую глубину, затем каждое число потоков
+// ищет ровно до неё
+bool runAiBenchmark(int maxThreads, std::chrono::milliseconds budget) {
+    bool passed = checkSearchEngine();
+
+    AiBoard board(15, 15, 5);
+    const int opening[][2] = {{7, 7}, {7, 8}, {8, 8}, {6, 6}, {8, 7}, {9, 9}, {6, 8}};
+    int player = 1;
+    for (auto& cell : opening) {
+        board.cells[cell[0] * board.width + cell[1]] = static_cast<int8_t>(player);
+        player = 3 - player;
+    }
+
+    int targetDepth = SearchEngine().findBestMove(board, player, {1, budget, 64}).depth;
+    std::cout << "Глубина для сравнения: " << targetDepth << std::endl;
+
+    double baseSeconds = 0.0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        SearchEngine engine;
+        SearchResult result = engine.findBestMove(board, player, {threads, budget * 10, targetDepth});
+        if (threads == 1) baseSeconds = result.elapsedSeconds;
+        bool reached = result.depth >= targetDepth;
+        std::cout << "Потоков: " << threads
+                  << ", время до глубины " << targetDepth << ": " << result.elapsedSeconds * 1000 << " мс"
+                  << (reached ? "" : " (не достигнута)")
+                  << ", ускорение: " << (reached && result.elapsedSeconds > 0 ? baseSeconds / result.elapsedSeconds : 0.0)
+                  << ", оценка: " << result.score
+                  << ", ход: " << result.move
+                  << ", узлов/с: " << static_cast<uint64_t>(result.nodesPerSecond) << std::endl;
+    }
+    return passed;
+}
+
+namespace {
+
+// Случайная партия 3x3 до победы или ничьей
+void playRandomGame(uint32_t& seed) {
+    Board board;
+    board.fill(' ');
+    char symbol = 'X';
+    while (!checkWin(board, 'X') && !checkWin(board, 'O') && std::count(board.begin(), board.end(), ' ') > 0) {
+        seed = seed * 1103515245u + 12345u;
+        if (makeMove(board, static_cast<int>((seed >> 16) % 9) + 1, symbol)) symbol = symbol == 'X' ? 'O' : 'X';
+    }
+}
+
+// Оба игрока в одном процессе: лобби создаётся, находится и захватывается через общий каталог
+uint64_t playLocalGames(SharedDirectory& directory, int process, std::chrono::steady_clock::time_point deadline) {
+    uint64_t games = 0;
+    uint32_t seed = static_cast<uint32_t>(getpid());
+    while (std::chrono::steady_clock::now() < deadline) {
+        std::string name = "bench" + std::to_string(process) + "-" + std::to_string(games);
+        SharedLobbyEntry entry;
+        SharedSlotRef ref;
+        if (!directory.publishLobby(name, process, 0, 3, false)) break;
+        if (!directory.findLobby(name, entry, ref) || !directory.claimLobby(ref)) break;
+        playRandomGame(seed);
+        ++games;
+    }
+    return games;
+}
+
+// Владелец и присоединившийся в разных процессах: процесс держит до PROCESS_BENCH_OPEN_LOBBIES
+// своих лобби, занимает лобби предыдущего процесса и передаёт владельцу сокет второго игрока
+// через SCM_RIGHTS. Партию доигрывает владелец, получив сокет, - так же, как runHandoverLoop
+uint64_t playHandoverGames(SharedDirectory& directory, int process, int processes, std::chrono::steady_clock::time_point deadline) {
+    const uint64_t PROCESS_BENCH_OPEN_LOBBIES = 16;
+    HandoverChannel channel;
+    if (!channel.listen(getpid())) return 0;
+
+    int target = (process + processes - 1) % processes;
+    uint64_t published = 0, joined = 0, games = 0;
+    uint32_t seed = static_cast<uint32_t>(getpid());
+    while (std::chrono::steady_clock::now() < deadline) {
+        // Владелец: новые лобби взамен доигранных. ownerSocket - номер лобби, второй сокет придёт с передачей
+        while (published - games < PROCESS_BENCH_OPEN_LOBBIES) {
+            std::string name = "handover" + std::to_string(process) + "-" + std::to_string(published);
+            if (!directory.publishLobby(name, process, static_cast<int>(published), 3, false)) return games;
+            ++published;
+        }
+
+        // Присоединившийся: игрок держит один конец socketpair, другой уходит владельцу лобби
+        SharedLobbyEntry entry;
+        SharedSlotRef ref;
+        std::string name = "handover" + std::to_string(target) + "-" + std::to_string(joined);
+        bool joining = directory.findLobby(name, entry, ref) && directory.claimLobby(ref);
+        if (joining) {
+            int pair[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) != 0) return games;
+            HandoverMessage message{};
+            memcpy(message.lobbyName, entry.name, SHARED_NAME_SIZE);
+            message.ownerId = entry.ownerId;
+            message.ownerSocket = entry.ownerSocket;
+            message.playerId = process;
+            // Ход присоединившегося лежит в сокете: владелец прочитает его из полученной копии
+            char move = '5';
+            bool sent = ::send(pair[1], &move, 1, MSG_NOSIGNAL) == 1 && channel.send(entry.ownerPid, message, pair[0]) == 0;
+            close(pair[0]);
+            close(pair[1]);
+            // Отказ только если процесс-владелец уже закончил замер
+            if (!sent) break;
+            ++joined;
+        }
+
+        // Владелец: принимаем переданные сокеты. Если занять было нечего, ждём передачи
+        // недолго, а не крутимся - иначе на одном ядре процессы отнимают время друг у друга
+        pollfd incoming{channel.fd(), POLLIN, 0};
+        int waitMs = joining ? 0 : 1;
+        while (poll(&incoming, 1, waitMs) > 0) {
+            waitMs = 0;
+            HandoverMessage message;
+            int secondPlayerSocket = channel.receive(message);
+            if (secondPlayerSocket < 0) break;
+            char move = 0;
+            bool delivered = recv(secondPlayerSocket, &move, 1, 0) == 1 && move == '5';
+            close(secondPlayerSocket);
+            if (!delivered) continue;
+            playRandomGame(seed);
+            ++games;
+        }
+    }
+    return games;
+}
+
+// Запускает processes процессов с общим каталогом и возвращает, сколько партий они доиграли
+uint64_t runProcessGames(int processes, const std::function<uint64_t(SharedDirectory&, int)>& play) {
+    SharedDirectory directory(LOBBY_DIRECTORY_CAPACITY, PRESENCE_DIRECTORY_CAPACITY);
+    int pipeFds[2];
+    if (!directory.valid() || pipe(pipeFds) != 0) return 0;
+
+    for (int p = 0; p < processes; ++p) {
+        if (fork() != 0) continue;
+        close(pipeFds[0]);
+        uint64_t games = play(directory, p);
+        ssize_t written = write(pipeFds[1], &games, sizeof(games));
+        _exit(written == sizeof(games) ? 0 : 1);
+    }
+
+    close(pipeFds[1]);
+    uint64_t total = 0;
+    uint64_t games;
+    while (read(pipeFds[0], &games, sizeof(games)) == sizeof(games)) total += games;
+    close(pipeFds[0]);
+    while (wait(nullptr) > 0) {}
+    return total;
+}
+
+}
+
+// Замер суммарной пропускной способности каталога и игровой логики на 1..N процессах:
+// сначала оба игрока каждой партии в одном процессе, затем каждая партия передаётся
+// процессу владельца через SCM_RIGHTS
+void runProcessBenchmark(int maxProcesses, std::chrono::milliseconds duration) {
+    double seconds = std::chrono::duration<double>(duration).count();
+    for (int processes = 1; processes <= maxProcesses; processes *= 2) {
+        uint64_t local = runProcessGames(processes, [&](SharedDirectory& directory, int process) {
+            return playLocalGames(directory, process, std::chrono::steady_clock::now() + duration);
+        });
+        uint64_t handedOver = runProcessGames(processes, [&](SharedDirectory& directory, int process) {
+            return playHandoverGames(directory, process, processes, std::chrono::steady_clock::now() + duration);
+        });
+        std::cout << "Процессов: " << processes << ", игр/с: " << static_cast<uint64_t>(local / seconds)
+                  << ", игр/с через передачу сокета: " << static_cast<uint64_t>(handedOver / seconds) << std::endl;
+    }
+}
+
+// Замер просмотра списка лобби: заполняем индекс и листаем страницы с фильтрами и без
+void runLobbyBenchmark(int lobbiesCount) {
+    LobbyIndex index([](int, std::string_view) { return true; });
+    for (int i = 0; i < lobbiesCount; ++i) {
+        index.add({"lobby" + std::to_string(i), i, i % 4 == 0 ? 15 : 3, i % 3 != 0});
+    }
+
+    auto measure = [&](const char* title, const LobbyFilter& filter) {
+        const int pages = 10000;
+        std::string cursor;
+        size_t returned = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < pages; ++i) {
+            LobbyPage page = index.browse(filter, cursor, LOBBY_PAGE_SIZE);
+            returned += page.lobbies.size();
+            cursor = page.nextCursor;
+        }
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / pages;
+        std::cout << title << ": " << micros << " мкс/страница (лобби в выдаче: " << returned << ")" << std::endl;
+    };
+
+    std::cout << "Открытых лобби: " << index.size() << std::endl;
+    measure("без фильтра", LobbyFilter{});
+    measure("префикс lobby12", LobbyFilter{"lobby12"});
+    measure("размер 15, без пароля", LobbyFilter{"", 15, 0});
+}
+
+// Сравнение стоимости записи в журнал на игровом потоке: прежний std::ostream с std::endl
+// против асинхронного логгера. Оба пишут в /dev/null, чтобы мерить только накладные расходы.
+// Потоки пишут подряд без пауз - это полная нагрузка: всё, что фоновый поток не успевает
+// вывести, теряется, и доля потерь печатается рядом со временем записи
+void runLogBenchmark(int threadsCount, int recordsPerThread) {
+    auto measure = [&](auto&& writeRecord) {
+        std::vector<std::thread> threads;
+        std::vector<double> nsPerRecord(threadsCount);
+        for (int t = 0; t < threadsCount; ++t) {
+            threads.emplace_back([&, t] {
+                auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < recordsPerThread; ++i) writeRecord(t, i);
+                auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+                nsPerRecord[t] = static_cast<double>(elapsed.count()) / recordsPerThread;
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        double sum = 0;
+        for (double value : nsPerRecord) sum += value;
+        return sum / threadsCount;
+    };
+
+    std::ofstream devNull("/dev/null");
+    std::mutex streamMutex;
+    double streamNs = measure([&](int t, int i) {
+        std::lock_guard<std::mutex> lock(streamMutex);
+        devNull << t << "-" << i << std::endl;
+    });
+
+    logger().open("/dev/null");
+    uint64_t droppedBefore = logger().droppedCount();
+    auto start = std::chrono::steady_clock::now();
+    double loggerNs = measure([](int t, int i) {
+        logInfo("Ход", {{"game", t}, {"player", t}, {"position", i % 9 + 1}, {"latency_us", i}});
+    });
+    logger().flush();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    logger().open("");
+
+    uint64_t total = static_cast<uint64_t>(threadsCount) * recordsPerThread;
+    uint64_t dropped = logger().droppedCount() - droppedBefore;
+    std::cout << "Потоков: " << threadsCount << ", записей на поток: " << recordsPerThread << " (без пауз)" << std::endl;
+    std::cout << "std::ostream + std::endl: " << streamNs << " нс/запись" << std::endl;
+    std::cout << "асинхронный логгер: " << loggerNs << " нс/запись, потеряно: " << dropped
+              << " из " << total << " (" << (total > 0 ? 100.0 * dropped / total : 0.0) << "%)" << std::endl;
+    std::cout << "выведено фоновым потоком: " << static_cast<uint64_t>((total - dropped) / seconds) << " записей/с" << std::endl;
+    std::cout << "ускорение записи: " << (loggerNs > 0 ? streamNs / loggerNs : 0.0) << std::endl;
+}
+
+namespace {
+
+size_t residentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t totalPages = 0, residentPages = 0;
+    statm >> totalPages >> residentPages;
+    return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// Читает со стороны клиента, пока не придёт подсказка marker
+bool readUntil(int socket, std::string_view marker) {
+    std::string received;
+    char chunk[4096];
+    while (received.find(marker) == std::string::npos) {
+        ssize_t bytes = read(socket, chunk, sizeof(chunk));
+        if (bytes <= 0) return false;
+        received.append(chunk, bytes);
+    }
+    return true;
+}
+
+}
+
+// Замер памяти: connections вошедших игроков, ждущих в меню лобби, затем столько же партий,
+// ждущих первого хода. Клиенты - настоящие обработчики на socketpair, разница RSS делится на число
+void runMemoryBenchmark(int connections) {
+    const size_t IDLE_TARGET_BYTES = 4096;
+
+    // Каждому соединению нужны два дескриптора, партии - четыре
+    rlimit files;
+    getrlimit(RLIMIT_NOFILE, &files);
+    files.rlim_cur = files.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &files);
+    int fitting = static_cast<int>((files.rlim_cur - 64) / 6);
+    if (connections > fitting) {
+        std::cout << "Лимит дескрипторов " << files.rlim_cur << ": соединений будет " << fitting << std::endl;
+        connections = fitting;
+    }
+
+    SharedDirectory directory(LOBBY_DIRECTORY_CAPACITY, PRESENCE_DIRECTORY_CAPACITY);
+    lobbyDirectory = &directory;
+    logger().open("/dev/null");
+    MemoryStorage storage;
+    // Клиенты подключаются по одному и дожидаются меню, так что к хранилищу обращается один поток за раз
+    admission.setLimits({connections * 2 + 16, 1e18, 1e18, 1e18, 1e18, 16});
+
+    std::vector<int> clientSockets;
+    size_t before = residentBytes();
+    int idle = 0;
+    for (; idle < connections; ++idle) {
+        int pair[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) != 0) break;
+        if (admission.admitConnection(0) != AdmissionControl::ADMIT || !startClientThread(pair[0], 0, storage)) {
+            close(pair[0]);
+            close(pair[1]);
+            break;
+        }
+        clientSockets.push_back(pair[1]);
+        std::string login = "idle" + std::to_string(idle) + " pw";
+        if (!readUntil(pair[1], "Вход: ") || write(pair[1], "1", 1) != 1
+            || !readUntil(pair[1], "аккаунта: ") || write(pair[1], login.data(), login.size()) != static_cast<ssize_t>(login.size())
+            || !readUntil(pair[1], "Список лобби): ")) break;
+    }
+    size_t afterIdle = residentBytes();
+    double perConnection = idle > 0 ? static_cast<double>(afterIdle - before) / idle : 0.0;
+    std::cout << "Соединений в меню лобби: " << idle
+              << ", RSS на соединение: " << static_cast<uint64_t>(perConnection) << " Б"
+              << " (цель < " << IDLE_TARGET_BYTES << " Б: " << (perConnection < IDLE_TARGET_BYTES ? "достигнута" : "не достигнута") << ")" << std::endl;
+
+    int games = 0;
+    for (; games < connections; ++games) {
+        int first[2], second[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, first) != 0) break;
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, second) != 0) {
+            close(first[0]);
+            close(first[1]);
+            break;
+        }
+        int p1 = first[0], p2 = second[0];
+        std::string name = "memory" + std::to_string(games);
+        bool started = startSessionThread([p1, p2, games, name, &storage] {
+            handleGameSession(GameSession(p1, p2, 2 * games + 1, 2 * games + 2, name), storage);
+        });
+        if (!started) break;
+        clientSockets.push_back(first[1]);
+        clientSockets.push_back(second[1]);
+        if (!readUntil(first[1], "(1-9): ")) break;
+    }
+    size_t afterGames = residentBytes();
+    std::cout << "Партий в ожидании хода: " << games
+              << ", RSS на партию: " << static_cast<uint64_t>(games > 0 ? static_cast<double>(afterGames - afterIdle) / games : 0.0) << " Б"
+              << " (два соединения и поток игры)" << std::endl;
+    std::cout << "Пул буферов: " << bufferPool.allocatedBytes() << " Б" << std::endl;
+}
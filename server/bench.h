@@ -0,0 +1,13 @@
+#pragma once
+
+#include <chrono>
+
+// Замеры производительности, запускаемые ключами --bench-* вместо сервера
+
+// Проверки движка и замер параллельного поиска; false - проверка движка не прошла
+bool runAiBenchmark(int maxThreads, std::chrono::milliseconds budget);
+void runProcessBenchmark(int maxProcesses, std::chrono::milliseconds duration);
+void runLobbyBenchmark(int lobbiesCount);
+void runLogBenchmark(int threadsCount, int recordsPerThread);
+// Оставляет потоки клиентов ждать ввода: после него процесс завершается через _exit
+void runMemoryBenchmark(int connections);
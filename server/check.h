@@ -0,0 +1,19 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+// Итог самопроверки (--bench-ai, --simulate): печатает результат каждой проверки
+// и запоминает, прошли ли все
+class CheckReport {
+public:
+    void operator()(const std::string& title, bool passed) {
+        std::cout << (passed ? "ок     " : "ОШИБКА ") << title << std::endl;
+        failed = failed || !passed;
+    }
+
+    bool allPassed() const { return !failed; }
+
+private:
+    bool failed = false;
+};
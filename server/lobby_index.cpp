@@ -0,0 +1,131 @@
+#include "lobby_index.h"
+
+#include <algorithm>
+
+bool LobbyFilter::matches(const LobbyInfo& lobby) const {
+    if (lobby.name.compare(0, prefix.size(), prefix) != 0) return false;
+    if (boardSize != 0 && lobby.boardSize != boardSize) return false;
+    if (hasPassword != -1 && lobby.hasPassword != (hasPassword == 1)) return false;
+    return true;
+}
+
+void LobbyIndex::add(const LobbyInfo& lobby) {
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        Category category(lobby.boardSize, lobby.hasPassword);
+        auto [it, inserted] = categoryByName.try_emplace(lobby.name, category);
+        if (!inserted && it->second != category) {
+            categories[it->second].erase(lobby.name);
+            it->second = category;
+        }
+        categories[category].insert_or_assign(lobby.name, lobby);
+    }
+    notify(lobby, "Открыто лобби: ");
+}
+
+void LobbyIndex::remove(const std::string& name) {
+    LobbyInfo removed;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto it = categoryByName.find(name);
+        if (it == categoryByName.end()) return;
+        LobbiesByName& lobbies = categories[it->second];
+        auto lobby = lobbies.find(name);
+        removed = std::move(lobby->second);
+        lobbies.erase(lobby);
+        categoryByName.erase(it);
+    }
+    notify(removed, "Лобби больше недоступно: ");
+}
+
+LobbyPage LobbyIndex::browse(const LobbyFilter& filter, const std::string& cursor, size_t pageSize) const {
+    LobbyPage page;
+    std::shared_lock<std::shared_mutex> lock(mutex);
+
+    // Из каждой подходящей категории берём не больше pageSize + 1 лобби (лишнее - признак следующей страницы)
+    std::vector<const LobbyInfo*> candidates;
+    for (const auto& [category, lobbies] : categories) {
+        if (filter.boardSize != 0 && category.first != filter.boardSize) continue;
+        if (filter.hasPassword != -1 && category.second != (filter.hasPassword == 1)) continue;
+
+        auto it = cursor.empty() ? lobbies.lower_bound(filter.prefix) : lobbies.upper_bound(cursor);
+        if (it != lobbies.end() && it->first < filter.prefix) it = lobbies.lower_bound(filter.prefix);
+
+        // Имена с общим префиксом идут в map подряд: первое несовпадение префикса - конец выборки
+        for (size_t taken = 0; it != lobbies.end() && taken <= pageSize; ++it, ++taken) {
+            if (it->first.compare(0, filter.prefix.size(), filter.prefix) != 0) break;
+            candidates.push_back(&it->second);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const LobbyInfo* a, const LobbyInfo* b) { return a->name < b->name; });
+    for (size_t i = 0; i < candidates.size() && i < pageSize; ++i) {
+        page.lobbies.push_back(*candidates[i]);
+    }
+    if (candidates.size() > pageSize) page.nextCursor = page.lobbies.back().name;
+    return page;
+}
+
+size_t LobbyIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return categoryByName.size();
+}
+
+std::vector<std::string> LobbyIndex::names() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::vector<std::string> result;
+    result.reserve(categoryByName.size());
+    for (const auto& [name, category] : categoryByName) result.push_back(name);
+    return result;
+}
+
+void LobbyIndex::subscribe(int socket, const LobbyFilter& filter) {
+    auto subscriber = std::make_shared<Subscriber>();
+    subscriber->filter = filter;
+    std::lock_guard<std::mutex> lock(subscribersMutex);
+    subscribers[socket] = std::move(subscriber);
+}
+
+void LobbyIndex::unsubscribe(int socket) {
+    std::shared_ptr<Subscriber> subscriber;
+    {
+        std::lock_guard<std::mutex> lock(subscribersMutex);
+        auto it = subscribers.find(socket);
+        if (it == subscribers.end()) return;
+        subscriber = std::move(it->second);
+        subscribers.erase(it);
+    }
+    // Дожидаемся отправки, начатой до снятия подписки
+    std::lock_guard<std::mutex> lock(subscriber->mutex);
+    subscriber->active = false;
+}
+
+void LobbyIndex::notify(const LobbyInfo& lobby, std::string_view event) {
+    std::string message = std::string(event) + lobby.name + "\n";
+    std::vector<std::pair<int, std::shared_ptr<Subscriber>>> recipients;
+    {
+        std::lock_guard<std::mutex> lock(subscribersMutex);
+        for (const auto& [socket, subscriber] : subscribers) {
+            if (subscriber->filter.matches(lobby)) recipients.emplace_back(socket, subscriber);
+        }
+    }
+
+    std::vector<std::pair<int, std::shared_ptr<Subscriber>>> failed;
+    for (auto& [socket, subscriber] : recipients) {
+        // Отправка без ожидания, так что блокировка подписчика держится недолго
+        std::lock_guard<std::mutex> lock(subscriber->mutex);
+        if (!subscriber->active || notifier(socket, message)) continue;
+        // Неактивна с этого момента: после снятия из списка unsubscribe не будет её ждать
+        subscriber->active = false;
+        failed.emplace_back(socket, subscriber);
+    }
+    if (failed.empty()) return;
+
+    // Клиент не читает уведомления (или отключился) - больше ему не пишем. Снимаем только ту
+    // подписку, на которой отправка не удалась: сокет мог уже подписаться заново
+    std::lock_guard<std::mutex> lock(subscribersMutex);
+    for (const auto& [socket, subscriber] : failed) {
+        auto it = subscribers.find(socket);
+        if (it != subscribers.end() && it->second == subscriber) subscribers.erase(it);
+    }
+}
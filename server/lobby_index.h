@@ -0,0 +1,81 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct LobbyInfo {
+    std::string name;
+    int ownerId = 0;
+    int boardSize = 3;
+    bool hasPassword = true;
+};
+
+struct LobbyFilter {
+    std::string prefix;
+    int boardSize = 0;     // 0 - любой размер
+    int hasPassword = -1;  // -1 - неважно, 0 - без пароля, 1 - с паролем
+
+    bool matches(const LobbyInfo& lobby) const;
+};
+
+struct LobbyPage {
+    std::vector<LobbyInfo> lobbies;
+    std::string nextCursor; // пустой, если страниц больше нет
+};
+
+// Индекс открытых (не заполненных) лобби в памяти, упорядоченный по имени.
+// Просмотр списка никогда не обращается к таблице lobbies
+class LobbyIndex {
+public:
+    // Должен отправлять без ожидания; false - сообщение не ушло целиком, подписчик снимается
+    using Notifier = std::function<bool(int socket, std::string_view message)>;
+
+    explicit LobbyIndex(Notifier notifier) : notifier(std::move(notifier)) {}
+
+    void add(const LobbyInfo& lobby);
+    // Лобби заполнилось или удалено - из списка открытых оно уходит
+    void remove(const std::string& name);
+
+    // cursor - имя последнего лобби предыдущей страницы; страница начинается строго после него,
+    // поэтому курсор остаётся корректным, даже если между запросами лобби открываются и заполняются
+    LobbyPage browse(const LobbyFilter& filter, const std::string& cursor, size_t pageSize) const;
+    size_t size() const;
+    std::vector<std::string> names() const;
+
+    // Подписка на изменения: подписчику отправляются открытия и заполнения лобби, подходящих под фильтр.
+    // Отправка идёт вне общей блокировки, так что медленный клиент не задерживает остальных
+    void subscribe(int socket, const LobbyFilter& filter);
+    // После возврата отправок в этот сокет нет и не будет - его можно закрывать
+    // (иначе уведомление могло бы уйти соединению, получившему тот же номер)
+    void unsubscribe(int socket);
+
+private:
+    void notify(const LobbyInfo& lobby, std::string_view event);
+
+    using Category = std::pair<int, bool>; // размер доски, есть ли пароль
+    using LobbiesByName = std::map<std::string, LobbyInfo, std::less<>>;
+
+    Notifier notifier;
+    mutable std::shared_mutex mutex;
+    // Отдельный упорядоченный список на каждую комбинацию фильтров: выборка с фильтром
+    // не пропускает неподходящие лобби, а сливает по странице из подходящих категорий
+    std::map<Category, LobbiesByName> categories;
+    std::unordered_map<std::string, Category> categoryByName;
+
+    // Отправка подписчику идёт под его собственной блокировкой и только пока он активен
+    struct Subscriber {
+        LobbyFilter filter;
+        std::mutex mutex;
+        bool active = true;
+    };
+
+    std::mutex subscribersMutex;
+    std::unordered_map<int, std::shared_ptr<Subscriber>> subscribers;
+};
@@ -0,0 +1,190 @@
+#include "logger.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+
+const int LOG_ERROR_BURST = 10;
+const std::chrono::milliseconds LOG_IDLE_SLEEP(1);
+
+namespace {
+
+const char* levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO: return "INFO ";
+        case LogLevel::WARN: return "WARN ";
+        case LogLevel::ERROR: return "ERROR";
+    }
+    return "?    ";
+}
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+}
+
+LogQueue::LogQueue() : cells(new Cell[CAPACITY]) {
+    for (size_t i = 0; i < CAPACITY; ++i) cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool LogQueue::push(const LogRecord& record) {
+    size_t position = enqueuePosition.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &cells[position & (CAPACITY - 1)];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (difference == 0) {
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+        } else if (difference < 0) {
+            return false; // очередь заполнена
+        } else {
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+    cell->record = record;
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool LogQueue::pop(LogRecord& record) {
+    Cell& cell = cells[dequeuePosition & (CAPACITY - 1)];
+    if (cell.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) return false;
+    record = cell.record;
+    cell.sequence.store(dequeuePosition + CAPACITY, std::memory_order_release);
+    ++dequeuePosition;
+    return true;
+}
+
+Logger::Logger() : worker(&Logger::run, this) {}
+
+Logger::~Logger() {
+    flush();
+    stopping.store(true);
+    worker.join();
+    std::lock_guard<std::mutex> lock(outputMutex);
+    if (output != stdout) fclose(output);
+}
+
+bool Logger::open(const std::string& path) {
+    FILE* file = path.empty() ? stdout : fopen(path.c_str(), "a");
+    if (!file) return false;
+    std::lock_guard<std::mutex> lock(outputMutex);
+    if (output != stdout) fclose(output);
+    output = file;
+    return true;
+}
+
+void Logger::write(LogLevel level, const char* message, std::initializer_list<LogField> fields, std::string_view text) {
+    LogRecord record;
+    record.timestampNs = nowNs();
+    record.message = message;
+    record.level = level;
+    record.fieldsCount = 0;
+    for (const LogField& field : fields) {
+        if (record.fieldsCount == LOG_MAX_FIELDS) break;
+        record.fields[record.fieldsCount++] = field;
+    }
+    size_t textSize = std::min(text.size(), static_cast<size_t>(LOG_TEXT_SIZE));
+    // Не режем многобайтный символ UTF-8 посередине
+    while (textSize < text.size() && textSize > 0 && (static_cast<unsigned char>(text[textSize]) & 0xC0) == 0x80) --textSize;
+    record.textSize = static_cast<uint8_t>(textSize);
+    memcpy(record.text, text.data(), record.textSize);
+
+    // Переполненная очередь не тормозит игру: запись теряется и учитывается в счётчике
+    if (!queue.push(record)) dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Logger::writeLimited(LogLevel level, const char* message, std::initializer_list<LogField> fields, std::string_view text) {
+    RateSlot& slot = rateSlots[(reinterpret_cast<uintptr_t>(message) >> 3) % 64];
+    int64_t now = nowNs();
+    int64_t windowStart = slot.windowStart.load(std::memory_order_relaxed);
+    if (now - windowStart >= 1000000000LL && slot.windowStart.compare_exchange_strong(windowStart, now)) {
+        slot.count.store(0, std::memory_order_relaxed);
+        int suppressed = slot.suppressed.exchange(0, std::memory_order_relaxed);
+        if (suppressed > 0) write(LogLevel::WARN, "Ошибки пропущены из-за ограничения частоты", {{"suppressed", suppressed}}, message);
+    }
+    if (slot.count.fetch_add(1, std::memory_order_relaxed) >= LOG_ERROR_BURST) {
+        slot.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    write(level, message, fields, text);
+}
+
+void Logger::flush() {
+    // Два полных цикла фонового потока после вызова гарантируют, что всё записанное до него уже в файле
+    uint64_t start = cycles.load(std::memory_order_acquire);
+    while (cycles.load(std::memory_order_acquire) < start + 2) {
+        std::this_thread::sleep_for(LOG_IDLE_SLEEP);
+    }
+}
+
+void Logger::format(const LogRecord& record, std::string& out) {
+    int64_t second = record.timestampNs / 1000000000LL;
+    if (second != prefixSecond) {
+        time_t seconds = static_cast<time_t>(second);
+        tm local;
+        localtime_r(&seconds, &local);
+        prefixLength = strftime(prefix, sizeof(prefix), "%Y-%m-%d %H:%M:%S", &local);
+        prefixSecond = second;
+    }
+
+    char head[32];
+    int micros = static_cast<int>((record.timestampNs / 1000) % 1000000);
+    int headLength = snprintf(head, sizeof(head), ".%06d %s ", micros, levelName(record.level));
+    out.append(prefix, prefixLength);
+    out.append(head, headLength);
+    out.append(record.message);
+
+    char number[24];
+    for (int i = 0; i < record.fieldsCount; ++i) {
+        out.push_back(' ');
+        out.append(record.fields[i].key);
+        out.push_back('=');
+        char* end = std::to_chars(number, number + sizeof(number), record.fields[i].value).ptr;
+        out.append(number, end - number);
+    }
+    if (record.textSize > 0) {
+        out.append(" text=\"");
+        out.append(record.text, record.textSize);
+        out.push_back('"');
+    }
+    out.push_back('\n');
+}
+
+size_t Logger::drain(std::string& batch) {
+    size_t count = 0;
+    LogRecord record;
+    // Не больше одной очереди за проход: при непрерывной записи пачка всё равно должна уходить в файл
+    while (count < LogQueue::CAPACITY && queue.pop(record)) {
+        format(record, batch);
+        ++count;
+    }
+    return count;
+}
+
+void Logger::run() {
+    std::string batch;
+    while (true) {
+        bool stop = stopping.load();
+        batch.clear();
+        size_t count = drain(batch);
+        if (count > 0) {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            fwrite(batch.data(), 1, batch.size(), output);
+            fflush(output);
+        }
+        cycles.fetch_add(1, std::memory_order_release);
+        if (stop) break;
+        if (count == 0) std::this_thread::sleep_for(LOG_IDLE_SLEEP);
+    }
+}
+
+Logger& logger() {
+    static Logger instance;
+    return instance;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+enum class LogLevel : uint8_t { DEBUG = 0, INFO = 1, WARN = 2, ERROR = 3 };
+
+// Структурированное поле записи: ключ - строковый литерал, значение - число
+struct LogField {
+    const char* key;
+    int64_t value;
+};
+
+const int LOG_MAX_FIELDS = 5;
+const int LOG_TEXT_SIZE = 96;
+
+// Запись хранится в бинарном виде; форматирование делает фоновый поток.
+// message и ключи полей не копируются, поэтому должны быть строковыми литералами
+struct LogRecord {
+    int64_t timestampNs;
+    const char* message;
+    LogField fields[LOG_MAX_FIELDS];
+    uint8_t fieldsCount;
+    uint8_t textSize;
+    LogLevel level;
+    char text[LOG_TEXT_SIZE]; // короткий произвольный текст (имя пользователя, e.what()), обрезается
+};
+
+// Общая для всех потоков ограниченная очередь (много писателей, один читатель). Ячейка хранит
+// номер позиции, для которой она свободна или заполнена: писатель занимает позицию одним CAS,
+// читатель - фоновый поток - видит готовую запись по номеру. Память фиксирована и не зависит
+// от числа потоков, поэтому тысячи потоков-клиентов не несут каждый свой буфер
+class LogQueue {
+public:
+    static const size_t CAPACITY = 8192; // степень двойки
+
+    LogQueue();
+
+    bool push(const LogRecord& record);
+    // Только фоновый поток
+    bool pop(LogRecord& record);
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    alignas(64) std::atomic<size_t> enqueuePosition{0};
+    alignas(64) size_t dequeuePosition = 0;
+};
+
+// Асинхронный логгер: запись в журнал на игровом пути - это копирование записи
+// в общую очередь, без блокировок, форматирования и системных вызовов
+class Logger {
+public:
+    Logger();
+    ~Logger();
+
+    // Открывает файл журнала; пустой путь - stdout
+    bool open(const std::string& path);
+    void setLevel(LogLevel level) { minLevel.store(level, std::memory_order_relaxed); }
+    bool enabled(LogLevel level) const { return level >= minLevel.load(std::memory_order_relaxed); }
+
+    void write(LogLevel level, const char* message, std::initializer_list<LogField> fields, std::string_view text);
+    // Не больше LOG_ERROR_BURST записей в секунду с одним и тем же message, остальные только считаются
+    void writeLimited(LogLevel level, const char* message, std::initializer_list<LogField> fields, std::string_view text);
+
+    // Дожидается, пока фоновый поток запишет всё накопленное
+    void flush();
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct RateSlot {
+        std::atomic<int64_t> windowStart{0};
+        std::atomic<int> count{0};
+        std::atomic<int> suppressed{0};
+    };
+
+    void run();
+    size_t drain(std::string& batch);
+    void format(const LogRecord& record, std::string& out);
+
+    std::atomic<LogLevel> minLevel{LogLevel::INFO};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> cycles{0};
+
+    LogQueue queue;
+    RateSlot rateSlots[64];
+
+    // Префикс времени форматируется заново только при смене секунды
+    int64_t prefixSecond = -1;
+    char prefix[32];
+    size_t prefixLength = 0;
+
+    std::mutex outputMutex;
+    FILE* output = stdout;
+    std::thread worker;
+};
+
+Logger& logger();
+
+inline void logDebug(const char* message, std::initializer_list<LogField> fields = {}, std::string_view text = {}) {
+    if (logger().enabled(LogLevel::DEBUG)) logger().write(LogLevel::DEBUG, message, fields, text);
+}
+
+inline void logInfo(const char* message, std::initializer_list<LogField> fields = {}, std::string_view text = {}) {
+    if (logger().enabled(LogLevel::INFO)) logger().write(LogLevel::INFO, message, fields, text);
+}
+
+inline void logWarn(const char* message, std::initializer_list<LogField> fields = {}, std::string_view text = {}) {
+    if (logger().enabled(LogLevel::WARN)) logger().write(LogLevel::WARN, message, fields, text);
+}
+
+// Ошибки ограничены по частоте: при сбое базы одна и та же ошибка не должна забивать журнал
+inline void logError(const char* message, std::initializer_list<LogField> fields = {}, std::string_view text = {}) {
+    if (logger().enabled(LogLevel::ERROR)) logger().writeLimited(LogLevel::ERROR, message, fields, text);
+}
@@ -0,0 +1,29 @@
+#include "pool.h"
+
+BufferPool::BufferPool(size_t bufferSize, size_t buffersPerSlab) : size(bufferSize), perSlab(buffersPerSlab) {}
+
+void BufferPool::addSlab() {
+    slabs.emplace_back(new char[size * perSlab]);
+    char* slab = slabs.back().get();
+    for (size_t i = 0; i < perSlab; ++i) {
+        freeList.push_back(slab + i * size);
+    }
+}
+
+char* BufferPool::acquire() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (freeList.empty()) addSlab();
+    char* buffer = freeList.back();
+    freeList.pop_back();
+    return buffer;
+}
+
+void BufferPool::release(char* buffer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    freeList.push_back(buffer);
+}
+
+size_t BufferPool::allocatedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return slabs.size() * size * perSlab;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Пул буферов одинакового размера: память выделяется блоками (slab) и после
+// закрытия соединения возвращается в список свободных, а не в malloc
+class BufferPool {
+public:
+    BufferPool(size_t bufferSize, size_t buffersPerSlab);
+
+    char* acquire();
+    void release(char* buffer);
+
+    size_t bufferSize() const { return size; }
+    size_t allocatedBytes() const;
+
+private:
+    void addSlab();
+
+    size_t size;
+    size_t perSlab;
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<char[]>> slabs;
+    std::vector<char*> freeList;
+};
+
+// Буфер, взятый из пула на время жизни объекта
+class PooledBuffer {
+public:
+    explicit PooledBuffer(BufferPool& pool) : pool(pool), buffer(pool.acquire()) {}
+    ~PooledBuffer() { pool.release(buffer); }
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    char* data() { return buffer; }
+    size_t size() const { return pool.bufferSize(); }
+
+private:
+    BufferPool& pool;
+    char* buffer;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "ai.h"
+#include "admission.h"
+#include "pool.h"
+#include "lobby_index.h"
+#include "shared_directory.h"
+#include "transport.h"
+#include "storage.h"
+
+// Части сервера из main.cpp, которыми пользуются самопроверки и замеры (simulate.cpp, bench.cpp)
+
+const size_t LOBBY_PAGE_SIZE = 10;
+const size_t LOBBY_DIRECTORY_CAPACITY = 1 << 17; // степень двойки
+const size_t PRESENCE_DIRECTORY_CAPACITY = 1 << 17;
+const std::chrono::milliseconds BOT_MOVE_BUDGET(300);
+
+using Board = std::array<char, 9>;
+
+extern std::atomic<int> nextGameId;
+
+// Сессия только перемещается: доска и имя лобби принадлежат ровно одному владельцу
+struct GameSession {
+    int gameId;
+    int player1Socket;
+    int player2Socket;
+    int player1Id;
+    int player2Id;
+    Board board;
+    std::string lobbyName;
+
+    GameSession(int p1, int p2, int p1Id, int p2Id, std::string lobbyName) : gameId(nextGameId.fetch_add(1)), player1Socket(p1), player2Socket(p2), player1Id(p1Id), player2Id(p2Id), lobbyName(std::move(lobbyName)) { board.fill(' '); }
+    GameSession(GameSession&&) = default;
+    GameSession& operator=(GameSession&&) = default;
+    GameSession(const GameSession&) = delete;
+    GameSession& operator=(const GameSession&) = delete;
+};
+
+extern AdmissionControl admission;
+extern BufferPool bufferPool;
+extern SearchLimits botLimits;
+// Все обращения к клиенту идут через транспорт: в режиме --simulate он подменяется транспортом в памяти
+extern SocketTransport socketTransport;
+extern Transport* transport;
+extern LobbyIndex lobbyIndex;
+// Каталог общий для всех процессов-воркеров; создаётся в main до fork
+extern SharedDirectory* lobbyDirectory;
+
+bool makeMove(Board& board, int position, char playerSymbol);
+bool checkWin(const Board& board, char playerSymbol);
+std::string hashPassword(const std::string& password);
+
+void handleClient(int clientSocket, uint32_t clientAddress, Storage& storage);
+void handleGameSession(GameSession&& session, Storage& storage);
+bool startSessionThread(std::function<void()> task);
+bool startClientThread(int clientSocket, uint32_t clientAddress, Storage& storage);
+
+void reapParkedOwners(Storage& storage);
+void sweepDeadProcesses(Storage& storage);
+size_t parkedOwnersCount();
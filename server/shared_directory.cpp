@@ -0,0 +1,265 @@
+#include "shared_directory.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+uint32_t hashName(std::string_view name) {
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : name) {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+uint32_t hashPlayer(int playerId) {
+    uint32_t hash = static_cast<uint32_t>(playerId) * 2654435761u;
+    return hash ^ (hash >> 16);
+}
+
+// Мьютекс писателей в общей памяти: виден всем процессам и переживает смерть владельца
+void initWriteLock(pthread_mutex_t* mutex) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+sockaddr_un handoverAddress(int pid, socklen_t& length) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    // Первый байт '\0' - абстрактный адрес: файл не создаётся и не требует удаления
+    std::string name = "tictactoe-handover-" + std::to_string(pid);
+    memcpy(address.sun_path + 1, name.data(), name.size());
+    length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + name.size());
+    return address;
+}
+
+}
+
+SharedDirectory::SharedDirectory(size_t lobbyCapacity, size_t presenceCapacity) {
+    size_t headerBytes = (sizeof(Header) + 63) / 64 * 64;
+    size_t logBytes = (sizeof(LobbyLogSlot) * SHARED_LOBBY_LOG_CAPACITY + 63) / 64 * 64;
+    size_t lobbyBytes = LobbyTable::bytesFor(lobbyCapacity);
+    size_t presenceBytes = PresenceTable::bytesFor(presenceCapacity);
+    mappedBytes = headerBytes + logBytes + lobbyBytes + presenceBytes;
+
+    // Анонимное разделяемое отображение обнуляется ядром и наследуется при fork
+    void* mapped = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) return;
+
+    memory = mapped;
+    char* base = static_cast<char*>(memory);
+    header = reinterpret_cast<Header*>(base);
+    initWriteLock(&header->lobbyControl.writeLock);
+    initWriteLock(&header->presenceControl.writeLock);
+    lobbyLog = reinterpret_cast<LobbyLogSlot*>(base + headerBytes);
+    lobbies.attach(base + headerBytes + logBytes, lobbyCapacity, &header->lobbyControl);
+    presence.attach(base + headerBytes + logBytes + lobbyBytes, presenceCapacity, &header->presenceControl);
+}
+
+SharedDirectory::~SharedDirectory() {
+    if (memory) munmap(memory, mappedBytes);
+}
+
+bool SharedDirectory::publishLobby(const std::string& name, int ownerId, int ownerSocket, int boardSize, bool hasPassword) {
+    if (name.size() >= SHARED_NAME_SIZE) return false;
+    SharedLobbyEntry entry{};
+    memcpy(entry.name, name.data(), name.size());
+    entry.ownerId = ownerId;
+    entry.ownerSocket = ownerSocket;
+    entry.ownerPid = getpid();
+    entry.boardSize = boardSize;
+    entry.hasPassword = hasPassword;
+    return insertLobby(entry);
+}
+
+bool SharedDirectory::republishLobby(const SharedLobbyEntry& entry) {
+    return insertLobby(entry);
+}
+
+bool SharedDirectory::insertLobby(const SharedLobbyEntry& entry) {
+    LobbyTable::WriteGuard guard(lobbies);
+    if (!lobbies.insert(guard, hashName(std::string_view(entry.name, strnlen(entry.name, SHARED_NAME_SIZE))), entry)) return false;
+    appendLobbyEvent(guard, SharedLobbyEvent::ADD, entry);
+    return true;
+}
+
+bool SharedDirectory::findLobby(std::string_view name, SharedLobbyEntry& entry, SharedSlotRef& ref) const {
+    return lobbies.find(hashName(name), [&](const SharedLobbyEntry& candidate) {
+        return std::string_view(candidate.name, strnlen(candidate.name, SHARED_NAME_SIZE)) == name;
+    }, entry, ref);
+}
+
+bool SharedDirectory::claimLobby(const SharedSlotRef& ref) {
+    LobbyTable::WriteGuard guard(lobbies);
+    SharedLobbyEntry erased;
+    if (!lobbies.erase(guard, ref, &erased)) return false;
+    appendLobbyEvent(guard, SharedLobbyEvent::REMOVE, erased);
+    return true;
+}
+
+bool SharedDirectory::removeLobby(std::string_view name) {
+    LobbyTable::WriteGuard guard(lobbies);
+    SharedLobbyEntry entry;
+    SharedSlotRef ref;
+    if (!findLobby(name, entry, ref) || !lobbies.erase(guard, ref)) return false;
+    appendLobbyEvent(guard, SharedLobbyEvent::REMOVE, entry);
+    return true;
+}
+
+void SharedDirectory::forEachLobby(const std::function<void(const SharedLobbyEntry&)>& callback) const {
+    lobbies.forEach(callback);
+}
+
+void SharedDirectory::appendLobbyEvent(const LobbyTable::WriteGuard&, SharedLobbyEvent::Kind kind, const SharedLobbyEntry& entry) {
+    uint64_t sequence = header->lobbyLogHead.load(std::memory_order_relaxed) + 1;
+    LobbyLogSlot& slot = lobbyLog[sequence % SHARED_LOBBY_LOG_CAPACITY];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event.kind = kind;
+    slot.event.pid = getpid();
+    slot.event.entry = entry;
+    slot.sequence.store(sequence, std::memory_order_release);
+    header->lobbyLogHead.store(sequence, std::memory_order_release);
+}
+
+uint64_t SharedDirectory::lobbyChangeSequence() const {
+    return header->lobbyLogHead.load(std::memory_order_acquire);
+}
+
+bool SharedDirectory::readLobbyChanges(uint64_t& sequence, const std::function<void(const SharedLobbyEvent&)>& callback) const {
+    uint64_t head = header->lobbyLogHead.load(std::memory_order_acquire);
+    if (head - sequence > SHARED_LOBBY_LOG_CAPACITY) {
+        sequence = head;
+        return false;
+    }
+
+    int pid = getpid();
+    for (uint64_t next = sequence + 1; next <= head; ++next) {
+        const LobbyLogSlot& slot = lobbyLog[next % SHARED_LOBBY_LOG_CAPACITY];
+        // Номер в слоте другой - событие успели перезаписать, пока мы читали предыдущие
+        if (slot.sequence.load(std::memory_order_acquire) != next) {
+            sequence = head;
+            return false;
+        }
+        SharedLobbyEvent event = slot.event;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != next) {
+            sequence = head;
+            return false;
+        }
+        if (event.pid != pid) callback(event);
+    }
+    sequence = head;
+    return true;
+}
+
+void SharedDirectory::setPresence(int playerId) {
+    PresenceTable::WriteGuard guard(presence);
+    erasePresence(guard, playerId);
+    presence.insert(guard, hashPlayer(playerId), SharedPresenceEntry{playerId, getpid()});
+}
+
+void SharedDirectory::clearPresence(int playerId) {
+    PresenceTable::WriteGuard guard(presence);
+    erasePresence(guard, playerId);
+}
+
+void SharedDirectory::erasePresence(const PresenceTable::WriteGuard& guard, int playerId) {
+    SharedPresenceEntry entry;
+    SharedSlotRef ref;
+    auto match = [playerId](const SharedPresenceEntry& candidate) { return candidate.playerId == playerId; };
+    while (presence.find(hashPlayer(playerId), match, entry, ref)) {
+        presence.erase(guard, ref);
+    }
+}
+
+int SharedDirectory::presenceOf(int playerId) const {
+    SharedPresenceEntry entry;
+    SharedSlotRef ref;
+    auto match = [playerId](const SharedPresenceEntry& candidate) { return candidate.playerId == playerId; };
+    return presence.find(hashPlayer(playerId), match, entry, ref) ? entry.pid : -1;
+}
+
+size_t SharedDirectory::presenceCount() const {
+    return presence.count();
+}
+
+void SharedDirectory::forEachPresence(const std::function<void(const SharedPresenceEntry&)>& callback) const {
+    presence.forEach(callback);
+}
+
+bool processExited(int pid) {
+    // kill с pid <= 0 адресован группе процессов, а не одному
+    return pid > 0 && kill(pid, 0) != 0 && errno == ESRCH;
+}
+
+HandoverChannel::HandoverChannel() {}
+
+HandoverChannel::~HandoverChannel() {
+    if (socketFd >= 0) close(socketFd);
+}
+
+bool HandoverChannel::listen(int pid) {
+    socketFd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (socketFd < 0) return false;
+    socklen_t length;
+    sockaddr_un address = handoverAddress(pid, length);
+    return bind(socketFd, reinterpret_cast<sockaddr*>(&address), length) == 0;
+}
+
+int HandoverChannel::send(int pid, const HandoverMessage& message, int clientSocket) {
+    socklen_t length;
+    sockaddr_un address = handoverAddress(pid, length);
+
+    iovec payload{const_cast<HandoverMessage*>(&message), sizeof(message)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+    msghdr header{};
+    header.msg_name = &address;
+    header.msg_namelen = length;
+    header.msg_iov = &payload;
+    header.msg_iovlen = 1;
+    header.msg_control = control;
+    header.msg_controllen = sizeof(control);
+
+    cmsghdr* rights = CMSG_FIRSTHDR(&header);
+    rights->cmsg_level = SOL_SOCKET;
+    rights->cmsg_type = SCM_RIGHTS;
+    rights->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(rights), &clientSocket, sizeof(int));
+
+    if (sendmsg(socketFd, &header, 0) == static_cast<ssize_t>(sizeof(message))) return 0;
+    return errno != 0 ? errno : EIO;
+}
+
+int HandoverChannel::receive(HandoverMessage& message) {
+    iovec payload{&message, sizeof(message)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+    msghdr header{};
+    header.msg_iov = &payload;
+    header.msg_iovlen = 1;
+    header.msg_control = control;
+    header.msg_controllen = sizeof(control);
+
+    ssize_t received = recvmsg(socketFd, &header, MSG_CMSG_CLOEXEC);
+    if (received != static_cast<ssize_t>(sizeof(message))) return -1;
+
+    cmsghdr* rights = CMSG_FIRSTHDR(&header);
+    if (!rights || rights->cmsg_level != SOL_SOCKET || rights->cmsg_type != SCM_RIGHTS) return -1;
+    int clientSocket;
+    memcpy(&clientSocket, CMSG_DATA(rights), sizeof(int));
+    message.lobbyName[SHARED_NAME_SIZE - 1] = '\0';
+    return clientSocket;
+}
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cerrno>
+#include <functional>
+#include <pthread.h>
+#include <string>
+#include <string_view>
+
+const size_t SHARED_NAME_SIZE = 64;
+
+// Лобби в общем каталоге. ownerSocket имеет смысл только в процессе ownerPid
+struct SharedLobbyEntry {
+    char name[SHARED_NAME_SIZE];
+    int ownerId;
+    int ownerSocket;
+    int ownerPid;
+    int boardSize;
+    bool hasPassword;
+};
+
+struct SharedPresenceEntry {
+    int playerId;
+    int pid;
+};
+
+// Ссылка на конкретную версию записи: после удаления или повторного использования слота
+// поколение меняется, и операция над устаревшей ссылкой не пройдёт
+struct SharedSlotRef {
+    size_t index;
+    uint64_t state;
+};
+
+// Управляющие поля таблицы, лежат в заголовке общей памяти. writeLock - разделяемый между
+// процессами robust-мьютекс (см. SharedDirectory): процесс, убитый с ним в руках, не блокирует остальных
+struct SharedTableControl {
+    pthread_mutex_t writeLock;
+    std::atomic<uint64_t> version;
+};
+
+// Хеш-таблица с открытой адресацией в разделяемой памяти. Читатели не блокируются:
+// состояние слота - одно 64-битное слово: поколение << 2 | статус. Запись заполняется,
+// пока слот помечен BUSY, читатель проверяет, что состояние не изменилось за время копирования.
+// Писатели (вставка и удаление) идут по одному под мьютексом в общей памяти - это
+// позволяет возвращать надгробия DELETED в FREE, иначе за время работы они заполнили бы
+// всю таблицу и поиск отсутствующего ключа проходил бы её целиком
+template <typename Entry>
+class SharedTable {
+public:
+    enum Status : uint64_t { FREE = 0, BUSY = 1, OPEN = 2, DELETED = 3 };
+
+    struct Slot {
+        std::atomic<uint64_t> state;
+        uint32_t hash;
+        Entry entry;
+    };
+
+    // Блокировка писателей. Если предыдущий владелец умер под ней (EOWNERDEAD), он мог
+    // оставить слот в BUSY - таблица чинится, и мьютекс снова помечается согласованным
+    class WriteGuard {
+    public:
+        explicit WriteGuard(SharedTable& table) : control(table.control) {
+            if (pthread_mutex_lock(&control->writeLock) == EOWNERDEAD) {
+                table.recover();
+                pthread_mutex_consistent(&control->writeLock);
+            }
+        }
+        ~WriteGuard() { pthread_mutex_unlock(&control->writeLock); }
+        WriteGuard(const WriteGuard&) = delete;
+        WriteGuard& operator=(const WriteGuard&) = delete;
+
+    private:
+        SharedTableControl* control;
+    };
+
+    static size_t bytesFor(size_t capacity) { return sizeof(Slot) * capacity; }
+
+    void attach(void* memory, size_t capacity, SharedTableControl* control) {
+        slots = static_cast<Slot*>(memory);
+        mask = capacity - 1;
+        this->control = control;
+    }
+
+    bool insert(const WriteGuard&, uint32_t hash, const Entry& entry) {
+        for (size_t probe = 0; probe <= mask; ++probe) {
+            Slot& slot = slots[(hash + probe) & mask];
+            uint64_t state = slot.state.load(std::memory_order_acquire);
+            // Неудачный CAS обновляет state: пробуем тот же слот, пока он остаётся свободным
+            while ((state & 3) == FREE || (state & 3) == DELETED) {
+                uint64_t generation = state >> 2;
+                if (!slot.state.compare_exchange_weak(state, (generation << 2) | BUSY, std::memory_order_acquire)) continue;
+
+                slot.hash = hash;
+                slot.entry = entry;
+                slot.state.store(((generation + 1) << 2) | OPEN, std::memory_order_release);
+                control->version.fetch_add(1, std::memory_order_release);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename Match>
+    bool find(uint32_t hash, Match match, Entry& out, SharedSlotRef& ref) const {
+        for (size_t probe = 0; probe <= mask; ++probe) {
+            size_t index = (hash + probe) & mask;
+            const Slot& slot = slots[index];
+            uint64_t state = slot.state.load(std::memory_order_acquire);
+            if ((state & 3) == FREE) return false; // дальше цепочка пробирования не продолжалась
+            if ((state & 3) != OPEN || slot.hash != hash) continue;
+
+            Entry copy = slot.entry;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.state.load(std::memory_order_relaxed) != state) continue;
+            if (!match(copy)) continue;
+
+            out = copy;
+            ref = {index, state};
+            return true;
+        }
+        return false;
+    }
+
+    // Ровно один из конкурирующих вызовов для одной версии записи вернёт true.
+    // erased - копия удалённой записи
+    bool erase(const WriteGuard&, const SharedSlotRef& ref, Entry* erased = nullptr) {
+        uint64_t expected = ref.state;
+        uint64_t generation = (ref.state >> 2) + 1;
+        Slot& slot = slots[ref.index];
+        if (!slot.state.compare_exchange_strong(expected, (generation << 2) | DELETED, std::memory_order_acq_rel)) {
+            return false;
+        }
+        if (erased) *erased = slot.entry;
+        reclaim(ref.index);
+        control->version.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    void forEach(const std::function<void(const Entry&)>& callback) const {
+        for (size_t index = 0; index <= mask; ++index) {
+            const Slot& slot = slots[index];
+            uint64_t state = slot.state.load(std::memory_order_acquire);
+            if ((state & 3) != OPEN) continue;
+            Entry copy = slot.entry;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.state.load(std::memory_order_relaxed) == state) callback(copy);
+        }
+    }
+
+    size_t count() const {
+        size_t result = 0;
+        for (size_t index = 0; index <= mask; ++index) {
+            if ((slots[index].state.load(std::memory_order_acquire) & 3) == OPEN) ++result;
+        }
+        return result;
+    }
+
+    // Меняется при каждой вставке и удалении
+    uint64_t version() const { return control->version.load(std::memory_order_acquire); }
+
+private:
+    // Вставка, прерванная смертью процесса, оставила слот в BUSY: поиск его пропускает,
+    // но ни вставка, ни удаление его больше не тронут. Превращаем его в надгробие
+    void recover() {
+        for (size_t index = 0; index <= mask; ++index) {
+            uint64_t state = slots[index].state.load(std::memory_order_relaxed);
+            if ((state & 3) != BUSY) continue;
+            slots[index].state.store((((state >> 2) + 1) << 2) | DELETED, std::memory_order_release);
+            reclaim(index);
+        }
+    }
+
+    // Надгробие нужно, только пока через слот продолжается чья-то цепочка пробирования.
+    // Если следующий слот свободен, ни одна цепочка дальше не идёт: слот и стоящие перед ним
+    // надгробия снова становятся FREE. Поколение сохраняется, так что старые ссылки не оживут
+    void reclaim(size_t index) {
+        if ((slots[(index + 1) & mask].state.load(std::memory_order_relaxed) & 3) != FREE) return;
+        for (size_t step = 0; step <= mask; ++step) {
+            Slot& slot = slots[(index - step) & mask];
+            uint64_t state = slot.state.load(std::memory_order_relaxed);
+            if ((state & 3) != DELETED) break;
+            slot.state.store((state >> 2) << 2 | FREE, std::memory_order_release);
+        }
+    }
+
+    Slot* slots = nullptr;
+    size_t mask = 0;
+    SharedTableControl* control = nullptr;
+};
+
+// Изменение списка лобби в общем журнале; pid - процесс, который его сделал
+struct SharedLobbyEvent {
+    enum Kind : int { ADD, REMOVE };
+
+    Kind kind;
+    int pid;
+    SharedLobbyEntry entry;
+};
+
+// Сколько последних изменений лобби хранит журнал; отставший сильнее процесс перечитывает каталог
+const size_t SHARED_LOBBY_LOG_CAPACITY = 1024;
+
+// Общий для процессов-воркеров каталог лобби и присутствия игроков.
+// Память создаётся до fork и наследуется дочерними процессами
+class SharedDirectory {
+public:
+    SharedDirectory(size_t lobbyCapacity, size_t presenceCapacity);
+    ~SharedDirectory();
+    SharedDirectory(const SharedDirectory&) = delete;
+    SharedDirectory& operator=(const SharedDirectory&) = delete;
+
+    bool valid() const { return memory != nullptr; }
+
+    bool publishLobby(const std::string& name, int ownerId, int ownerSocket, int boardSize, bool hasPassword);
+    // Возвращает в каталог ранее захваченное лобби с тем же владельцем, его процессом и сокетом
+    bool republishLobby(const SharedLobbyEntry& entry);
+    bool findLobby(std::string_view name, SharedLobbyEntry& entry, SharedSlotRef& ref) const;
+    // Забирает лобби для присоединения: из двух одновременно присоединяющихся игроков успеет один
+    bool claimLobby(const SharedSlotRef& ref);
+    bool removeLobby(std::string_view name);
+    void forEachLobby(const std::function<void(const SharedLobbyEntry&)>& callback) const;
+
+    // Номер последнего изменения лобби в журнале
+    uint64_t lobbyChangeSequence() const;
+    // Передаёт изменения лобби после sequence, сделанные другими процессами, и сдвигает sequence.
+    // false - процесс отстал и часть журнала уже перезаписана: каталог нужно перечитать целиком
+    bool readLobbyChanges(uint64_t& sequence, const std::function<void(const SharedLobbyEvent&)>& callback) const;
+
+    void setPresence(int playerId);
+    void clearPresence(int playerId);
+    // pid процесса, обслуживающего игрока, или -1
+    int presenceOf(int playerId) const;
+    size_t presenceCount() const;
+    void forEachPresence(const std::function<void(const SharedPresenceEntry&)>& callback) const;
+
+private:
+    using LobbyTable = SharedTable<SharedLobbyEntry>;
+    using PresenceTable = SharedTable<SharedPresenceEntry>;
+
+    struct Header {
+        alignas(64) SharedTableControl lobbyControl;
+        alignas(64) SharedTableControl presenceControl;
+        alignas(64) std::atomic<uint64_t> lobbyLogHead;
+    };
+
+    // sequence == 0 - запись пишется прямо сейчас; иначе номер лежащего в ней события
+    struct LobbyLogSlot {
+        std::atomic<uint64_t> sequence;
+        SharedLobbyEvent event;
+    };
+
+    bool insertLobby(const SharedLobbyEntry& entry);
+    // Вызывается под блокировкой писателей лобби, поэтому пишущий в журнал всегда один
+    void appendLobbyEvent(const LobbyTable::WriteGuard&, SharedLobbyEvent::Kind kind, const SharedLobbyEntry& entry);
+    void erasePresence(const PresenceTable::WriteGuard& guard, int playerId);
+
+    void* memory = nullptr;
+    size_t mappedBytes = 0;
+    Header* header = nullptr;
+    LobbyLogSlot* lobbyLog = nullptr;
+    LobbyTable lobbies;
+    PresenceTable presence;
+};
+
+// Процесс pid завершился: его записи в каталоге больше некому обслуживать
+bool processExited(int pid);
+
+// Сообщение о передаче игры процессу владельца лобби; сам сокет второго игрока
+// передаётся рядом через SCM_RIGHTS
+struct HandoverMessage {
+    char lobbyName[SHARED_NAME_SIZE];
+    int ownerId;
+    int ownerSocket;
+    int playerId;
+};
+
+// Unix-сокет процесса для приёма чужих соединений (абстрактное пространство имён Linux)
+class HandoverChannel {
+public:
+    HandoverChannel();
+    ~HandoverChannel();
+
+    bool listen(int pid);
+    int fd() const { return socketFd; }
+
+    // Отправляет сокет клиента процессу pid; после успеха (0) вызывающий закрывает свою копию.
+    // Иначе возвращает errno: ECONNREFUSED - у процесса pid больше нет канала
+    int send(int pid, const HandoverMessage& message, int clientSocket);
+    // Возвращает полученный сокет или -1
+    int receive(HandoverMessage& message);
+
+private:
+    int socketFd = -1;
+};
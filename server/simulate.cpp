@@ -0,0 +1,413 @@
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstring>
+#include "simulate.h"
+#include "check.h"
+#include "logger.h"
+#include "server.h"
+
+const int SIMULATION_BATCH = 64; // пар клиентов, одновременно идущих в --simulate
+
+namespace {
+
+// Сообщения, которые клиент отправит серверу по порядку
+using ClientScript = std::vector<std::string>;
+
+// Дописывает в сценарии ходы одной партии: клетки в случайном (по seed) порядке, пока партия
+// не закончится. Возвращает символ победителя или '\0' при ничьей
+char appendGame(ClientScript& xMoves, ClientScript& oMoves, uint32_t& seed) {
+    std::array<int, 9> cells = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    for (int i = 8; i > 0; --i) {
+        seed = seed * 1103515245u + 12345u;
+        std::swap(cells[i], cells[(seed >> 16) % (i + 1)]);
+    }
+
+    Board board;
+    board.fill(' ');
+    for (int i = 0; i < 9; ++i) {
+        char symbol = i % 2 == 0 ? 'X' : 'O';
+        makeMove(board, cells[i], symbol);
+        (symbol == 'X' ? xMoves : oMoves).push_back(std::to_string(cells[i]));
+        if (checkWin(board, symbol)) return symbol;
+    }
+    return '\0';
+}
+
+int openScripted(MemoryTransport& memory, const ClientScript& script) {
+    int connection = memory.open();
+    for (const std::string& message : script) memory.push(connection, message);
+    return connection;
+}
+
+// Обработчик клиента получает соединение так же, как после accept в main
+void simulateClient(Storage& storage, int connection) {
+    if (admission.admitConnection(0) != AdmissionControl::ADMIT) return;
+    handleClient(connection, 0, storage);
+}
+
+size_t countOccurrences(const std::string& text, std::string_view pattern) {
+    size_t count = 0;
+    for (size_t position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + 1)) ++count;
+    return count;
+}
+
+bool lobbyClosed(Storage& storage, const std::string& name) {
+    SharedLobbyEntry entry;
+    SharedSlotRef ref;
+    auto names = lobbyIndex.names();
+    return storage.checkLobby(name, hashPassword("pw")) == LobbyCheck::NOT_FOUND
+        && !lobbyDirectory->findLobby(name, entry, ref)
+        && std::find(names.begin(), names.end(), name) == names.end();
+}
+
+// Сценарии гонок и обрывов соединения, которые раньше воспроизводились только вручную
+bool runSimulationScenarios(uint32_t seed) {
+    CheckReport report;
+    int baselineSessions = admission.stats().activeSessions;
+
+    {
+        MemoryTransport memory(seed);
+        MemoryStorage storage;
+        transport = &memory;
+        ClientScript owner = {"1", "owner pw", "1", "full pw"};
+        ClientScript joiner = {"1", "joiner pw", "2", "full pw"};
+        char winner = appendGame(owner, joiner, seed);
+        owner.push_back("нет");
+        joiner.push_back("нет");
+        int a = openScripted(memory, owner);
+        int b = openScripted(memory, joiner);
+        simulateClient(storage, a);
+        simulateClient(storage, b);
+
+        int ownerId = *storage.authenticateUser("owner", hashPassword("pw"));
+        int joinerId = *storage.authenticateUser("joiner", hashPassword("pw"));
+        std::optional<int> expected;
+        if (winner) expected = winner == 'X' ? ownerId : joinerId;
+        report("партия от входа до выхода", storage.matches().size() == 1 && storage.matches()[0].winner == expected
+            && memory.closedByServer(a) && memory.closedByServer(b) && storage.sessionsCount() == 0
+            && lobbyClosed(storage, "full") && lobbyDirectory->presenceOf(ownerId) < 0 && lobbyDirectory->presenceOf(joinerId) < 0);
+    }
+
+    {
+        // Второй игрок успевает забрать лобби между проверкой и захватом у первого
+        MemoryTransport memory(seed);
+        MemoryStorage storage;
+        transport = &memory;
+        ClientScript owner = {"1", "owner pw", "1", "race pw"};
+        ClientScript late = {"1", "late pw", "2", "race pw"};
+        ClientScript fast = {"1", "fast pw", "2", "race pw"};
+        appendGame(owner, fast, seed);
+        owner.push_back("нет");
+        fast.push_back("нет");
+        int a = openScripted(memory, owner);
+        int b = openScripted(memory, late);
+        int c = openScripted(memory, fast);
+        simulateClient(storage, a);
+
+        bool raced = false;
+        storage.onLobbyChecked = [&](const std::string&) {
+            if (raced) return;
+            raced = true;
+            simulateClient(storage, c);
+        };
+        simulateClient(storage, b);
+        storage.onLobbyChecked = nullptr;
+
+        report("два игрока присоединяются к одному лобби", raced && storage.matches().size() == 1
+            && countOccurrences(memory.output(c), "Игра началась") == 1
+            && countOccurrences(memory.output(b), "Игра началась") == 0
+            && countOccurrences(memory.output(b), "Ошибка при присоединении") == 1
+            && memory.closedByServer(a) && memory.closedByServer(b) && memory.closedByServer(c)
+            && storage.sessionsCount() == 0 && lobbyClosed(storage, "race"));
+    }
+
+    {
+        // Владелец отключается, не ответив на вопрос о повторной игре
+        MemoryTransport memory(seed);
+        MemoryStorage storage;
+        transport = &memory;
+        ClientScript owner = {"1", "owner pw", "1", "replay pw"};
+        ClientScript joiner = {"1", "joiner pw", "2", "replay pw"};
+        appendGame(owner, joiner, seed);
+        joiner.push_back("да");
+        int a = openScripted(memory, owner);
+        int b = openScripted(memory, joiner);
+        simulateClient(storage, a);
+        simulateClient(storage, b);
+
+        report("отключение на вопросе о повторной игре", storage.matches().size() == 1
+            && countOccurrences(memory.output(b), "Игра началась") == 1
+            && countOccurrences(memory.output(b), "Хотите сыграть еще раз?") == 1
+            && memory.closedByServer(a) && memory.closedByServer(b)
+            && storage.sessionsCount() == 0 && lobbyClosed(storage, "replay"));
+    }
+
+    {
+        // Второй игрок пропадает после первого хода
+        MemoryTransport memory(seed);
+        MemoryStorage storage;
+        transport = &memory;
+        ClientScript owner = {"1", "owner pw", "1", "drop pw"};
+        ClientScript joiner = {"1", "joiner pw", "2", "drop pw"};
+        appendGame(owner, joiner, seed);
+        int a = openScripted(memory, owner);
+        int b = openScripted(memory, joiner);
+        memory.disconnect(b, 5);
+        simulateClient(storage, a);
+        simulateClient(storage, b);
+
+        report("отключение посреди партии", storage.matches().empty()
+            && memory.closedByServer(a) && memory.closedByServer(b)
+            && storage.sessionsCount() == 0 && lobbyClosed(storage, "drop"));
+    }
+
+    {
+        // После "да" игроки меняются символами; победа должна записываться тому, кто ходил
+        MemoryTransport memory(seed);
+        MemoryStorage storage;
+        transport = &memory;
+        ClientScript owner = {"1", "owner pw", "1", "again pw"};
+        ClientScript joiner = {"1", "joiner pw", "2", "again pw"};
+        char first = appendGame(owner, joiner, seed);
+        owner.push_back("да");
+        joiner.push_back("да");
+        char second = appendGame(joiner, owner, seed);
+        owner.push_back("нет");
+        joiner.push_back("нет");
+        int a = openScripted(memory, owner);
+        int b = openScripted(memory, joiner);
+        simulateClient(storage, a);
+        simulateClient(storage, b);
+
+        int ownerId = *storage.authenticateUser("owner", hashPassword("pw"));
+        int joinerId = *storage.authenticateUser("joiner", hashPassword("pw"));
+        std::optional<int> expectedFirst, expectedSecond;
+        if (first) expectedFirst = first == 'X' ? ownerId : joinerId;
+        if (second) expectedSecond = second == 'X' ? joinerId : ownerId;
+        report("повторная партия со сменой символов", storage.matches().size() == 2
+            && storage.matches()[0].winner == expectedFirst && storage.matches()[1].winner == expectedSecond
+            && memory.closedByServer(a) && memory.closedByServer(b) && lobbyClosed(storage, "again"));
+    }
+
+    {
+        // Лобби без пароля находится фильтром "нет" и принимает присоединение по одному имени
+        MemoryTransport memory(seed);
+        MemoryStorage storage;
+        transport = &memory;
+        ClientScript owner = {"1", "owner pw", "1", "open"};
+        ClientScript joiner = {"1", "joiner pw", "5", "op;;нет", "2", "open"};
+        appendGame(owner, joiner, seed);
+        owner.push_back("нет");
+        joiner.push_back("нет");
+        int a = openScripted(memory, owner);
+        int b = openScripted(memory, joiner);
+        simulateClient(storage, a);
+        simulateClient(storage, b);
+
+        report("лобби без пароля", storage.matches().size() == 1
+            && countOccurrences(memory.output(b), "open (3×3, без пароля)") == 1
+            && memory.closedByServer(a) && memory.closedByServer(b)
+            && storage.sessionsCount() == 0 && storage.lobbiesCount() == 0);
+    }
+
+    {
+        // Пустые чтения после обрыва на этапе входа не должны зацикливать обработчик
+        MemoryTransport memory(seed);
+        MemoryStorage storage;
+        transport = &memory;
+        int a = openScripted(memory, {"1"});
+        simulateClient(storage, a);
+        report("отключение при регистрации", memory.closedByServer(a) && storage.sessionsCount() == 0);
+    }
+
+    {
+        // Процесс владельца не принял передачу игры: лобби должно вернуться владельцу целиком
+        MemoryTransport memory(seed);
+        MemoryStorage storage;
+        transport = &memory;
+        int ownerId = *storage.registerUser("ghost", hashPassword("pw"));
+        storage.createLobby("ghost", hashPassword(""), ownerId);
+        SharedLobbyEntry ghost{};
+        memcpy(ghost.name, "ghost", 5);
+        ghost.ownerId = ownerId;
+        ghost.ownerSocket = 1000;
+        ghost.ownerPid = getppid(); // процесс жив, но канал передачи в симуляции не открыт - отправка не пройдёт
+        ghost.boardSize = 3;
+        lobbyDirectory->republishLobby(ghost);
+        int a = openScripted(memory, {"1", "joiner pw", "2", "ghost", "3"});
+        simulateClient(storage, a);
+
+        SharedLobbyEntry entry;
+        SharedSlotRef ref;
+        auto names = lobbyIndex.names();
+        bool restored = lobbyDirectory->findLobby("ghost", entry, ref)
+            && entry.ownerPid == ghost.ownerPid && entry.ownerSocket == ghost.ownerSocket
+            && storage.checkLobby("ghost", hashPassword("")) == LobbyCheck::OK
+            && std::find(names.begin(), names.end(), "ghost") != names.end();
+        report("сбой передачи игры возвращает лобби владельцу", restored
+            && countOccurrences(memory.output(a), "Ошибка при присоединении") == 1);
+
+        lobbyDirectory->removeLobby("ghost");
+        lobbyIndex.remove("ghost");
+    }
+
+    {
+        // Процесс владельца умер: лобби не возвращается в каталог, а удаляется, и то же
+        // делает периодическая очистка с лобби, к которым никто не присоединялся
+        MemoryTransport memory(seed);
+        MemoryStorage storage;
+        transport = &memory;
+        pid_t child = fork();
+        if (child == 0) _exit(0);
+        waitpid(child, nullptr, 0);
+
+        auto publishOrphan = [&](const std::string& name) {
+            int ownerId = *storage.registerUser(name, hashPassword("pw"));
+            storage.addSession(ownerId, 1000);
+            storage.createLobby(name, hashPassword(""), ownerId);
+            SharedLobbyEntry orphan{};
+            memcpy(orphan.name, name.data(), name.size());
+            orphan.ownerId = ownerId;
+            orphan.ownerSocket = 1000;
+            orphan.ownerPid = child;
+            orphan.boardSize = 3;
+            lobbyDirectory->republishLobby(orphan);
+            lobbyIndex.add({name, ownerId, 3, false});
+        };
+        publishOrphan("orphan");
+        publishOrphan("swept");
+        int a = openScripted(memory, {"1", "joiner pw", "2", "orphan", "2", "orphan", "3"});
+        simulateClient(storage, a);
+        sweepDeadProcesses(storage);
+
+        report("лобби умершего процесса удаляются", lobbyClosed(storage, "orphan") && lobbyClosed(storage, "swept")
+            && storage.lobbiesCount() == 0 && storage.sessionsCount() == 0
+            && countOccurrences(memory.output(a), "Ошибка при присоединении") == 2);
+    }
+
+    size_t sharedLobbies = 0;
+    lobbyDirectory->forEachLobby([&](const SharedLobbyEntry&) { ++sharedLobbies; });
+    report("общий каталог пуст после сценариев", sharedLobbies == 0 && lobbyDirectory->presenceCount() == 0
+        && parkedOwnersCount() == 0 && admission.stats().activeSessions == baselineSessions);
+
+    transport = &socketTransport;
+    return report.allPassed();
+}
+
+struct SimulationResult {
+    double seconds;
+    uint64_t matches;
+    uint64_t virtualUs;
+    uint64_t checksum;
+    bool invariantsHeld;
+};
+
+// Прогон games пар клиентов (владелец лобби и присоединяющийся) через настоящие обработчики.
+// Пары идут пачками одновременно: каждый клиент - сопрограмма транспорта, и его сообщения
+// приходят с задержкой сети, так что чтения разных соединений перемешиваются. В каждой
+// восьмой паре третий клиент пытается занять то же лобби одновременно со вторым игроком
+SimulationResult runSimulationPass(const std::string& tag, int games, uint32_t seed, const TransportFaults& faults) {
+    SharedDirectory directory(LOBBY_DIRECTORY_CAPACITY, PRESENCE_DIRECTORY_CAPACITY);
+    lobbyDirectory = &directory;
+    // Индекс глобальный: лобби, оставшиеся от прошлого прогона, изменили бы вывод повтора
+    for (const std::string& name : lobbyIndex.names()) lobbyIndex.remove(name);
+    MemoryTransport memory(seed, faults, false);
+    MemoryStorage storage;
+    transport = &memory;
+    int baselineSessions = admission.stats().activeSessions;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int first = 0; first < games; first += SIMULATION_BATCH) {
+        uint64_t batchStart = memory.nowUs();
+        for (int i = first; i < games && i < first + SIMULATION_BATCH; ++i) {
+            std::string suffix = tag + std::to_string(i);
+            ClientScript owner = {"1", "o" + suffix + " pw", "1", "l" + suffix + " pw"};
+            ClientScript joiner = {"1", "j" + suffix + " pw", "2", "l" + suffix + " pw"};
+            appendGame(owner, joiner, seed);
+            owner.push_back("нет");
+            joiner.push_back("нет");
+
+            // Владельцы приходят вразброс, второй игрок - в среднем на одну задержку позже своего
+            seed = seed * 1103515245u + 12345u;
+            uint64_t ownerStart = batchStart + (seed >> 16) % (4 * faults.latencyUs + 1);
+            int a = openScripted(memory, owner);
+            int b = openScripted(memory, joiner);
+            memory.spawn([&storage, a] { simulateClient(storage, a); }, ownerStart);
+            memory.spawn([&storage, b] { simulateClient(storage, b); }, ownerStart + faults.latencyUs);
+            if (i % 8 == 7) {
+                int c = openScripted(memory, {"1", "r" + suffix + " pw", "2", "l" + suffix + " pw", "3"});
+                memory.spawn([&storage, c] { simulateClient(storage, c); }, ownerStart + faults.latencyUs);
+            }
+        }
+        memory.run();
+        reapParkedOwners(storage);
+    }
+
+    // Сценарии кончились: оставшиеся клиенты уходят, и ждавших владельцев должен убрать сервер
+    memory.disconnectAll();
+    reapParkedOwners(storage);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t sharedLobbies = 0;
+    directory.forEachLobby([&](const SharedLobbyEntry&) { ++sharedLobbies; });
+    bool invariantsHeld = storage.matches().size() <= static_cast<size_t>(games)
+        && storage.lobbiesCount() == 0 && sharedLobbies == 0 && lobbyIndex.size() == 0
+        && directory.presenceCount() == 0 && parkedOwnersCount() == 0
+        && memory.openByServer() == 0 && storage.sessionsCount() == 0
+        && admission.stats().activeSessions == baselineSessions;
+
+    transport = &socketTransport;
+    lobbyDirectory = nullptr;
+    return {seconds, storage.matches().size(), memory.nowUs(), memory.checksum(), invariantsHeld};
+}
+
+}
+
+// Детерминированная симуляция без сети и базы: сценарии гонок, затем замер пропускной
+// способности игровой логики. Один seed - один и тот же прогон байт в байт
+int runSimulation(int games, uint32_t seed) {
+    logger().setLevel(LogLevel::ERROR);
+    logger().open("/dev/null"); // обрывы соединений в сценариях намеренные
+    AdmissionLimits limits;
+    limits.maxSessions = 1 << 30;
+    limits.connectBurst = limits.authBurst = 1e18;
+    limits.connectPerSecond = limits.authPerSecond = 1e18;
+    admission.setLimits(limits);
+    botLimits.threads = 1;
+
+    SharedDirectory directory(LOBBY_DIRECTORY_CAPACITY, PRESENCE_DIRECTORY_CAPACITY);
+    lobbyDirectory = &directory;
+    bool passed = runSimulationScenarios(seed);
+    lobbyDirectory = nullptr;
+
+    TransportFaults faults;
+    faults.latencyUs = 2000;
+    faults.jitterUs = 1000;
+    faults.partialReadPercent = 2;
+    faults.disconnectPercent = 1;
+
+    auto print = [&](const char* title, const SimulationResult& result) {
+        std::cout << title << ": сессий/с: " << static_cast<uint64_t>(2 * games / result.seconds)
+                  << ", матчей: " << result.matches
+                  << ", виртуальное время: " << result.virtualUs / 1000 << " мс"
+                  << ", контрольная сумма: " << std::hex << result.checksum << std::dec
+                  << ", инварианты: " << (result.invariantsHeld ? "соблюдены" : "НАРУШЕНЫ") << std::endl;
+    };
+    SimulationResult clean = runSimulationPass("a", games, seed, TransportFaults());
+    print("без сбоев", clean);
+    SimulationResult faulty = runSimulationPass("b", games, seed, faults);
+    print("со сбоями", faulty);
+    SimulationResult repeated = runSimulationPass("c", games, seed, faults);
+    bool reproducible = repeated.checksum == faulty.checksum && repeated.matches == faulty.matches;
+    std::cout << "повтор с тем же seed совпал: " << (reproducible ? "да" : "нет") << std::endl;
+
+    bool invariantsHeld = clean.invariantsHeld && faulty.invariantsHeld && repeated.invariantsHeld;
+    return passed && reproducible && invariantsHeld ? 0 : 1;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstdint>
+
+// Детерминированная симуляция без сети и базы (--simulate): сценарии гонок и обрывов,
+// затем замер пропускной способности игровой логики. 0 - все проверки прошли
+int runSimulation(int games, uint32_t seed);
@@ -0,0 +1,281 @@
+#include "storage.h"
+
+#include "logger.h"
+
+PostgresStorage::PostgresStorage(const std::string& url) : C(url) {}
+
+void PostgresStorage::updateStatistics(int playerId, int result) {
+    try {
+        pqxx::work W(C);
+
+        // Подготовка значений для обновления в зависимости от результата игры
+        int winIncrement = (result == 1) ? 1 : 0;
+        int lossIncrement = (result == -1) ? 1 : 0;
+        int drawIncrement = (result == 0) ? 1 : 0;
+
+        // Вставка или обновление записи в таблице statistics
+        W.exec_params(
+            "INSERT INTO statistics (player_id, games_played, wins, losses, draws) "
+            "VALUES ($1, 1, $2, $3, $4) "
+            "ON CONFLICT (player_id) DO UPDATE "
+            "SET games_played = statistics.games_played + 1, "
+            "    wins = statistics.wins + EXCLUDED.wins, "
+            "    losses = statistics.losses + EXCLUDED.losses, "
+            "    draws = statistics.draws + EXCLUDED.draws;",
+            playerId, winIncrement, lossIncrement, drawIncrement
+        );
+
+        // Применяем изменения
+        W.commit();
+
+        logInfo("Статистика обновлена", {{"player", playerId}});
+    } catch (const std::exception& e) {
+        logError("Ошибка при обновлении статистики", {{"player", playerId}}, e.what());
+    }
+}
+
+bool PostgresStorage::deleteSession(int playerId) {
+    try {
+        pqxx::work W(C);
+
+        // Удаляем запись с указанным player_id из таблицы sessions
+        W.exec_params("DELETE FROM sessions WHERE player_id = $1;", playerId);
+
+        W.commit();
+        return true;
+    } catch (const std::exception& e) {
+        logError("Ошибка при удалении сессии", {{"player", playerId}}, e.what());
+        return false;
+    }
+}
+
+bool PostgresStorage::deleteLobby(const std::string& name) {
+    try {
+        pqxx::work W(C);
+        W.exec_params("DELETE FROM lobbies WHERE name = $1;", name);
+        W.commit();
+        return true;
+    } catch (const std::exception& e) {
+        logError("Ошибка при удалении лобби", {}, e.what());
+        return false;
+    }
+}
+
+void PostgresStorage::recordMatch(int player1Id, int player2Id, std::optional<int> winner) {
+    try {
+        pqxx::work W(C);
+
+        // Вставка новой записи в таблицу matches, если есть победитель или ничья
+        if (winner.has_value()) {
+            W.exec_params(
+                "INSERT INTO matches (player1_id, player2_id, winner_id) "
+                "VALUES ($1, $2, $3);",
+                player1Id, player2Id, winner.value()
+            );
+            W.commit();
+
+            updateStatistics(winner.value(), 1);
+            updateStatistics(winner.value() == player1Id ? player2Id : player1Id, -1);
+        } else {
+            W.exec_params(
+                "INSERT INTO matches (player1_id, player2_id, winner_id) "
+                "VALUES ($1, $2, NULL);",
+                player1Id, player2Id
+            );
+            W.commit();
+
+            updateStatistics(player1Id, 0);
+            updateStatistics(player2Id, 0);
+        }
+    } catch (const std::exception& e) {
+        logError("Ошибка при записи матча", {{"player1", player1Id}, {"player2", player2Id}}, e.what());
+    }
+}
+
+bool PostgresStorage::addSession(int playerId, int socket) {
+    try {
+        pqxx::work W(C);
+        pqxx::result R = W.exec_params("INSERT INTO sessions (player_id, socket) VALUES ($1, $2);", playerId, socket);
+
+        // Проверяем, был ли успешно выполнен запрос
+        if (R.affected_rows() == 0) {
+            logError("Не удалось добавить сессию", {{"player", playerId}});
+            return false; // Возвращаем false, если сессия не добавлена
+        }
+
+        W.commit(); // Фиксируем транзакцию только после успешного выполнения
+        return true;  // Возвращаем true, если сессия успешно добавлена
+    } catch (const std::exception& e) {
+        logError("Ошибка добавления сессии", {{"player", playerId}}, e.what());
+        return false;
+    }
+}
+
+std::optional<int> PostgresStorage::registerUser(const std::string& username, const std::string& passwordHash) {
+    try {
+        pqxx::work W(C);
+        pqxx::result R = W.exec_params(
+            "INSERT INTO players (username, password_hash) VALUES ($1, $2) ON CONFLICT DO NOTHING RETURNING id;",
+            username, passwordHash
+        );
+
+        if (!R.empty()) {
+            int newPlayerId = R[0][0].as<int>();  // Получаем id нового игрока
+            W.commit();
+            return newPlayerId;  // Возвращаем id нового пользователя
+        } else {
+            W.commit();
+            logWarn("Пользователь с таким именем уже существует", {}, username);
+            return std::nullopt;
+        }
+    } catch (const std::exception& e) {
+        logError("Ошибка регистрации", {}, e.what());
+        return std::nullopt;
+    }
+}
+
+std::optional<int> PostgresStorage::authenticateUser(const std::string& username, const std::string& passwordHash) {
+    try {
+        pqxx::work W(C);
+        pqxx::result R = W.exec_params("SELECT id FROM players WHERE username = $1 AND password_hash = $2;", username, passwordHash);
+
+        if (!R.empty()) {
+            int playerId = R[0][0].as<int>();  // Получаем id игрока
+            W.commit();
+            return playerId;  // Возвращаем id пользователя
+        }
+        W.commit();
+        return std::nullopt;  // Если игрок не найден
+    } catch (const std::exception& e) {
+        logError("Ошибка авторизации", {}, e.what());
+        return std::nullopt;
+    }
+}
+
+bool PostgresStorage::createLobby(const std::string& name, const std::string& passwordHash, int ownerId) {
+    try {
+        pqxx::work W(C);
+        pqxx::result R = W.exec_params(
+            "INSERT INTO lobbies (name, password_hash, owner_id) VALUES ($1, $2, $3) ON CONFLICT DO NOTHING RETURNING id;",
+            name, passwordHash, ownerId
+        );
+        W.commit();
+
+        if (R.empty()) {
+            logWarn("Лобби с таким именем уже существует", {{"player", ownerId}}, name);
+            return false;
+        }
+        return true;
+    } catch (const std::exception& e) {
+        logError("Ошибка создания лобби", {{"player", ownerId}}, e.what());
+        return false;
+    }
+}
+
+LobbyCheck PostgresStorage::checkLobby(const std::string& name, const std::string& passwordHash) {
+    try {
+        pqxx::work W(C);
+        pqxx::result R = W.exec_params("SELECT is_full FROM lobbies WHERE name = $1 AND password_hash = $2;", name, passwordHash);
+        W.commit();
+
+        if (R.empty()) return LobbyCheck::NOT_FOUND;
+        return R[0]["is_full"].as<bool>() ? LobbyCheck::FULL : LobbyCheck::OK;
+    } catch (const std::exception& e) {
+        logError("Ошибка при проверке лобби", {}, e.what());
+        return LobbyCheck::NOT_FOUND;
+    }
+}
+
+bool PostgresStorage::markLobbyFull(const std::string& name) {
+    try {
+        pqxx::work W(C);
+        W.exec_params("UPDATE lobbies SET is_full = TRUE WHERE name = $1;", name);
+        W.commit();
+        return true;
+    } catch (const std::exception& e) {
+        logError("Ошибка при обновлении лобби", {}, e.what());
+        return false;
+    }
+}
+
+bool PostgresStorage::reopenLobby(const std::string& name) {
+    try {
+        pqxx::work W(C);
+        W.exec_params("UPDATE lobbies SET is_full = FALSE WHERE name = $1;", name);
+        W.commit();
+        return true;
+    } catch (const std::exception& e) {
+        logError("Ошибка при обновлении лобби", {}, e.what());
+        return false;
+    }
+}
+
+std::optional<int> MemoryStorage::registerUser(const std::string& username, const std::string& passwordHash) {
+    auto [it, inserted] = players.try_emplace(username, Player{nextPlayerId, passwordHash});
+    if (!inserted) return std::nullopt;
+    return nextPlayerId++;
+}
+
+std::optional<int> MemoryStorage::authenticateUser(const std::string& username, const std::string& passwordHash) {
+    auto it = players.find(username);
+    if (it == players.end() || it->second.passwordHash != passwordHash) return std::nullopt;
+    return it->second.id;
+}
+
+bool MemoryStorage::addSession(int playerId, int socket) {
+    sessions[playerId] = socket;
+    return true;
+}
+
+bool MemoryStorage::deleteSession(int playerId) {
+    sessions.erase(playerId);
+    return true;
+}
+
+bool MemoryStorage::createLobby(const std::string& name, const std::string& passwordHash, int ownerId) {
+    return lobbies.try_emplace(name, Lobby{passwordHash, ownerId, false}).second;
+}
+
+LobbyCheck MemoryStorage::checkLobby(const std::string& name, const std::string& passwordHash) {
+    auto it = lobbies.find(name);
+    LobbyCheck result = it == lobbies.end() || it->second.passwordHash != passwordHash
+        ? LobbyCheck::NOT_FOUND
+        : (it->second.isFull ? LobbyCheck::FULL : LobbyCheck::OK);
+    if (onLobbyChecked) onLobbyChecked(name);
+    return result;
+}
+
+bool MemoryStorage::markLobbyFull(const std::string& name) {
+    auto it = lobbies.find(name);
+    if (it == lobbies.end()) return false;
+    it->second.isFull = true;
+    return true;
+}
+
+bool MemoryStorage::reopenLobby(const std::string& name) {
+    auto it = lobbies.find(name);
+    if (it == lobbies.end()) return false;
+    it->second.isFull = false;
+    return true;
+}
+
+bool MemoryStorage::deleteLobby(const std::string& name) {
+    lobbies.erase(name);
+    return true;
+}
+
+void MemoryStorage::recordMatch(int player1Id, int player2Id, std::optional<int> winner) {
+    matchLog.push_back({player1Id, player2Id, winner});
+    for (int playerId : {player1Id, player2Id}) {
+        PlayerStatistics& stats = statistics[playerId];
+        ++stats.gamesPlayed;
+        if (!winner) ++stats.draws;
+        else if (*winner == playerId) ++stats.wins;
+        else ++stats.losses;
+    }
+}
+
+PlayerStatistics MemoryStorage::statisticsOf(int playerId) const {
+    auto it = statistics.find(playerId);
+    return it == statistics.end() ? PlayerStatistics() : it->second;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <pqxx/pqxx>
+
+enum class LobbyCheck { OK, NOT_FOUND, FULL };
+
+// Хранилище игроков, сессий, лобби и матчей. Пароли приходят уже хешированными
+class Storage {
+public:
+    virtual ~Storage() = default;
+
+    // id нового игрока или nullopt, если имя занято
+    virtual std::optional<int> registerUser(const std::string& username, const std::string& passwordHash) = 0;
+    virtual std::optional<int> authenticateUser(const std::string& username, const std::string& passwordHash) = 0;
+    virtual bool addSession(int playerId, int socket) = 0;
+    virtual bool deleteSession(int playerId) = 0;
+
+    // false, если лобби с таким именем уже есть
+    virtual bool createLobby(const std::string& name, const std::string& passwordHash, int ownerId) = 0;
+    // Проверяет пароль и что лобби ещё не заполнено
+    virtual LobbyCheck checkLobby(const std::string& name, const std::string& passwordHash) = 0;
+    virtual bool markLobbyFull(const std::string& name) = 0;
+    // Снимает отметку о заполнении, если присоединение сорвалось
+    virtual bool reopenLobby(const std::string& name) = 0;
+    virtual bool deleteLobby(const std::string& name) = 0;
+
+    // Матч и статистика обоих игроков; winner == nullopt - ничья
+    virtual void recordMatch(int player1Id, int player2Id, std::optional<int> winner) = 0;
+};
+
+// PostgreSQL: по одному соединению на процесс
+class PostgresStorage : public Storage {
+public:
+    explicit PostgresStorage(const std::string& url);
+
+    std::optional<int> registerUser(const std::string& username, const std::string& passwordHash) override;
+    std::optional<int> authenticateUser(const std::string& username, const std::string& passwordHash) override;
+    bool addSession(int playerId, int socket) override;
+    bool deleteSession(int playerId) override;
+    bool createLobby(const std::string& name, const std::string& passwordHash, int ownerId) override;
+    LobbyCheck checkLobby(const std::string& name, const std::string& passwordHash) override;
+    bool markLobbyFull(const std::string& name) override;
+    bool reopenLobby(const std::string& name) override;
+    bool deleteLobby(const std::string& name) override;
+    void recordMatch(int player1Id, int player2Id, std::optional<int> winner) override;
+
+private:
+    void updateStatistics(int playerId, int result);
+
+    pqxx::connection C;
+};
+
+struct PlayerStatistics {
+    int gamesPlayed = 0;
+    int wins = 0;
+    int losses = 0;
+    int draws = 0;
+};
+
+struct MatchRecord {
+    int player1Id;
+    int player2Id;
+    std::optional<int> winner;
+};
+
+// Заглушка в памяти для симуляции: та же семантика, что у таблиц PostgreSQL, без блокировок -
+// рассчитана на однопоточный прогон
+class MemoryStorage : public Storage {
+public:
+    std::optional<int> registerUser(const std::string& username, const std::string& passwordHash) override;
+    std::optional<int> authenticateUser(const std::string& username, const std::string& passwordHash) override;
+    bool addSession(int playerId, int socket) override;
+    bool deleteSession(int playerId) override;
+    bool createLobby(const std::string& name, const std::string& passwordHash, int ownerId) override;
+    LobbyCheck checkLobby(const std::string& name, const std::string& passwordHash) override;
+    bool markLobbyFull(const std::string& name) override;
+    bool reopenLobby(const std::string& name) override;
+    bool deleteLobby(const std::string& name) override;
+    void recordMatch(int player1Id, int player2Id, std::optional<int> winner) override;
+
+    size_t sessionsCount() const { return sessions.size(); }
+    size_t lobbiesCount() const { return lobbies.size(); }
+    const std::vector<MatchRecord>& matches() const { return matchLog; }
+    PlayerStatistics statisticsOf(int playerId) const;
+
+    // Точка переключения для сценариев гонок: вызывается после проверки лобби,
+    // до того как вызывающий успеет его захватить
+    std::function<void(const std::string& name)> onLobbyChecked;
+
+private:
+    struct Player {
+        int id;
+        std::string passwordHash;
+    };
+
+    struct Lobby {
+        std::string passwordHash;
+        int ownerId;
+        bool isFull;
+    };
+
+    std::unordered_map<std::string, Player> players;
+    std::unordered_map<int, int> sessions;
+    std::unordered_map<std::string, Lobby> lobbies;
+    std::unordered_map<int, PlayerStatistics> statistics;
+    std::vector<MatchRecord> matchLog;
+    int nextPlayerId = 1;
+};
@@ -0,0 +1,226 @@
+#include "transport.h"
+
+#include <algorithm>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+int SocketTransport::send(int connection, std::string_view message) {
+    // MSG_NOSIGNAL: запись в сокет отключившегося клиента не должна убивать процесс SIGPIPE
+    return ::send(connection, message.data(), message.size(), MSG_NOSIGNAL);
+}
+
+int SocketTransport::trySend(int connection, std::string_view message) {
+    return ::send(connection, message.data(), message.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+}
+
+int SocketTransport::receive(int connection, char* buffer, size_t size) {
+    return ::recv(connection, buffer, size, 0);
+}
+
+void SocketTransport::close(int connection) {
+    ::close(connection);
+}
+
+std::vector<int> SocketTransport::hungUp(const std::vector<int>& connections) {
+    std::vector<pollfd> fds;
+    fds.reserve(connections.size());
+    for (int connection : connections) fds.push_back({connection, POLLRDHUP, 0});
+
+    std::vector<int> result;
+    if (fds.empty() || poll(fds.data(), fds.size(), 0) <= 0) return result;
+    for (const pollfd& fd : fds) {
+        if (fd.revents & (POLLRDHUP | POLLHUP | POLLERR | POLLNVAL)) result.push_back(fd.fd);
+    }
+    return result;
+}
+
+MemoryTransport::MemoryTransport(uint32_t seed, const TransportFaults& faults, bool captureOutput)
+    : seed(seed), faults(faults), captureOutput(captureOutput) {}
+
+uint32_t MemoryTransport::nextRandom() {
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 16;
+}
+
+// Когда клиент отправит следующее сообщение: задержка сети плюс случайная добавка
+uint64_t MemoryTransport::deliveryDelay() {
+    return faults.latencyUs + (faults.jitterUs > 0 ? nextRandom() % (faults.jitterUs + 1) : 0);
+}
+
+MemoryTransport::Connection* MemoryTransport::find(int connection) {
+    auto it = connections.find(connection);
+    return it == connections.end() ? nullptr : &it->second;
+}
+
+int MemoryTransport::open() {
+    int connection = nextConnection++;
+    Connection state;
+    state.readyAtUs = clockUs + deliveryDelay();
+    connections.emplace(connection, std::move(state));
+    return connection;
+}
+
+void MemoryTransport::push(int connection, std::string message) {
+    if (Connection* state = find(connection)) state->inbound.push_back(std::move(message));
+}
+
+void MemoryTransport::disconnect(int connection, size_t afterMessages) {
+    if (Connection* state = find(connection)) state->disconnectAfter = state->consumed + afterMessages;
+}
+
+void MemoryTransport::release(int connection) {
+    connections.erase(connection);
+}
+
+void MemoryTransport::disconnectAll() {
+    for (auto& [connection, state] : connections) state.peerClosed = true;
+}
+
+void MemoryTransport::spawn(std::function<void()> body, uint64_t startUs) {
+    auto task = std::make_unique<Task>();
+    task->id = nextTaskId++;
+    task->wakeAtUs = startUs;
+    task->body = std::move(body);
+    if (freeStacks.empty()) {
+        task->stack = std::make_unique<char[]>(TASK_STACK_SIZE);
+    } else {
+        task->stack = std::move(freeStacks.back());
+        freeStacks.pop_back();
+    }
+
+    getcontext(&task->context);
+    task->context.uc_stack.ss_sp = task->stack.get();
+    task->context.uc_stack.ss_size = TASK_STACK_SIZE;
+    task->context.uc_link = &schedulerContext;
+    // makecontext передаёт только int-аргументы: указатель на транспорт делим на две половины
+    uintptr_t self = reinterpret_cast<uintptr_t>(this);
+    makecontext(&task->context, reinterpret_cast<void (*)()>(&MemoryTransport::taskEntry), 2,
+                static_cast<uint32_t>(self), static_cast<uint32_t>(static_cast<uint64_t>(self) >> 32));
+    tasks.push_back(std::move(task));
+}
+
+void MemoryTransport::taskEntry(uint32_t low, uint32_t high) {
+    auto* self = reinterpret_cast<MemoryTransport*>(static_cast<uintptr_t>((static_cast<uint64_t>(high) << 32) | low));
+    self->current->body();
+    self->current->finished = true;
+}
+
+void MemoryTransport::run() {
+    while (!tasks.empty()) {
+        // Ближайшая по виртуальному времени задача; при равенстве - запущенная раньше
+        auto next = std::min_element(tasks.begin(), tasks.end(), [](const auto& a, const auto& b) {
+            return a->wakeAtUs != b->wakeAtUs ? a->wakeAtUs < b->wakeAtUs : a->id < b->id;
+        });
+        Task* task = next->get();
+        clockUs = std::max(clockUs, task->wakeAtUs);
+        current = task;
+        swapcontext(&schedulerContext, &task->context);
+        current = nullptr;
+
+        if (task->finished) {
+            auto it = std::find_if(tasks.begin(), tasks.end(), [task](const auto& candidate) { return candidate.get() == task; });
+            freeStacks.push_back(std::move(task->stack));
+            tasks.erase(it);
+        }
+    }
+}
+
+void MemoryTransport::waitUntil(uint64_t timeUs) {
+    if (timeUs <= clockUs) return;
+    if (!current) {
+        clockUs = timeUs;
+        return;
+    }
+    current->wakeAtUs = timeUs;
+    swapcontext(&current->context, &schedulerContext);
+}
+
+int MemoryTransport::send(int connection, std::string_view message) {
+    Connection* state = find(connection);
+    if (!state || state->serverClosed || state->peerClosed) return -1;
+
+    for (unsigned char c : message) {
+        outputHash ^= c;
+        outputHash *= 1099511628211ull;
+    }
+    sentBytes += message.size();
+    if (captureOutput) state->output.append(message);
+    return static_cast<int>(message.size());
+}
+
+int MemoryTransport::receive(int connection, char* buffer, size_t size) {
+    Connection* state = find(connection);
+    if (!state || state->serverClosed) return -1;
+    if (state->peerClosed) return 0;
+
+    // Ждём, пока сообщение (или обрыв) дойдёт; тем временем работают другие соединения
+    waitUntil(state->readyAtUs);
+    state = find(connection);
+    if (!state || state->serverClosed) return -1;
+    if (state->peerClosed) return 0;
+
+    if (state->inbound.empty() || state->consumed >= state->disconnectAfter
+        || (faults.disconnectPercent > 0 && static_cast<int>(nextRandom() % 100) < faults.disconnectPercent)) {
+        state->peerClosed = true;
+        return 0;
+    }
+
+    std::string& message = state->inbound.front();
+    size_t length = std::min(message.size(), size);
+    // Частичное чтение: как и у TCP, одно отправленное сообщение приходит несколькими кусками
+    if (length >= 2 && faults.partialReadPercent > 0 && static_cast<int>(nextRandom() % 100) < faults.partialReadPercent) {
+        length = 1 + nextRandom() % (length - 1);
+    }
+    memcpy(buffer, message.data(), length);
+    receivedBytes += length;
+
+    if (length == message.size()) {
+        state->inbound.pop_front();
+        ++state->consumed;
+        state->readyAtUs = clockUs + deliveryDelay();
+    } else {
+        message.erase(0, length);
+    }
+    return static_cast<int>(length);
+}
+
+void MemoryTransport::close(int connection) {
+    if (Connection* state = find(connection)) state->serverClosed = true;
+}
+
+std::vector<int> MemoryTransport::hungUp(const std::vector<int>& list) {
+    std::vector<int> result;
+    for (int connection : list) {
+        Connection* state = find(connection);
+        if (!state || state->peerClosed || state->inbound.empty() || state->consumed >= state->disconnectAfter) {
+            result.push_back(connection);
+        }
+    }
+    return result;
+}
+
+const std::string& MemoryTransport::output(int connection) const {
+    static const std::string empty;
+    auto it = connections.find(connection);
+    return it == connections.end() ? empty : it->second.output;
+}
+
+bool MemoryTransport::closedByServer(int connection) const {
+    auto it = connections.find(connection);
+    return it != connections.end() && it->second.serverClosed;
+}
+
+size_t MemoryTransport::pending(int connection) const {
+    auto it = connections.find(connection);
+    return it == connections.end() ? 0 : it->second.inbound.size();
+}
+
+size_t MemoryTransport::openByServer() const {
+    size_t count = 0;
+    for (const auto& [connection, state] : connections) {
+        if (!state.serverClosed) ++count;
+    }
+    return count;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <ucontext.h>
+
+// Транспорт соединений с клиентами. Игровая логика обращается к клиенту только через него,
+// поэтому её можно прогонять как по TCP, так и в памяти без сети
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    virtual int send(int connection, std::string_view message) = 0;
+    // Отправка без ожидания: если буфер отправки клиента заполнен, возвращает -1, а не блокирует поток
+    virtual int trySend(int connection, std::string_view message) = 0;
+    // Как recv: число прочитанных байт, 0 - клиент отключился, -1 - ошибка
+    virtual int receive(int connection, char* buffer, size_t size) = 0;
+    virtual void close(int connection) = 0;
+    // Из переданных соединений - те, чей клиент отключился. Не блокирует
+    virtual std::vector<int> hungUp(const std::vector<int>& connections) = 0;
+};
+
+// Обычные TCP-сокеты
+class SocketTransport : public Transport {
+public:
+    int send(int connection, std::string_view message) override;
+    int trySend(int connection, std::string_view message) override;
+    int receive(int connection, char* buffer, size_t size) override;
+    void close(int connection) override;
+    std::vector<int> hungUp(const std::vector<int>& connections) override;
+};
+
+// Сбои, которые транспорт в памяти вносит в сценарий. Все случайные решения берутся
+// из генератора с заданным seed, поэтому прогон с тем же seed повторяется байт в байт
+struct TransportFaults {
+    uint64_t latencyUs = 0;       // задержка доставки каждого сообщения (в виртуальном времени)
+    uint64_t jitterUs = 0;        // плюс случайная добавка 0..jitterUs
+    int partialReadPercent = 0;   // вероятность, что сообщение будет прочитано в два приёма
+    int disconnectPercent = 0;    // вероятность обрыва соединения перед очередным сообщением
+};
+
+// Детерминированный транспорт в памяти: входящие сообщения клиента задаются сценарием заранее,
+// всё отправленное сервером накапливается (или только считается). Сценарий закончился -
+// клиент считается отключившимся, так что обработчик никогда не блокируется.
+// Обработчики можно запускать как сопрограммы (spawn, run) в одном потоке: чтение ждёт,
+// пока сообщение дойдёт в виртуальном времени, а планировщик всегда продолжает задачу
+// с самым ранним временем пробуждения. Так задержки определяют порядок доставки между соединениями
+class MemoryTransport : public Transport {
+public:
+    static const size_t TASK_STACK_SIZE = 256 * 1024;
+
+    explicit MemoryTransport(uint32_t seed = 1, const TransportFaults& faults = TransportFaults(), bool captureOutput = true);
+
+    int open();
+    // Сообщение клиента, которое сервер получит следующим после уже поставленных в очередь
+    void push(int connection, std::string message);
+    // Обрыв соединения со стороны клиента после того, как сервер прочитает afterMessages сообщений
+    void disconnect(int connection, size_t afterMessages = 0);
+    // Забывает соединение, когда сценарий с ним закончен
+    void release(int connection);
+    // Все клиенты разом обрывают соединения
+    void disconnectAll();
+
+    // Задача стартует не раньше startUs виртуального времени
+    void spawn(std::function<void()> task, uint64_t startUs = 0);
+    // Выполняет задачи, пока все не завершатся
+    void run();
+
+    int send(int connection, std::string_view message) override;
+    // Буфер отправки в памяти не ограничен, поэтому отправка без ожидания - обычная отправка
+    int trySend(int connection, std::string_view message) override { return send(connection, message); }
+    int receive(int connection, char* buffer, size_t size) override;
+    void close(int connection) override;
+    // Отключившимся считается и клиент, которому больше нечего отправить
+    std::vector<int> hungUp(const std::vector<int>& connections) override;
+
+    const std::string& output(int connection) const;
+    bool closedByServer(int connection) const;
+    size_t pending(int connection) const;
+    // Соединения, которые сервер так и не закрыл
+    size_t openByServer() const;
+
+    uint64_t nowUs() const { return clockUs; }
+    uint64_t bytesSent() const { return sentBytes; }
+    uint64_t bytesReceived() const { return receivedBytes; }
+    // Контрольная сумма всего отправленного сервером: совпадает у повторных прогонов с тем же seed
+    uint64_t checksum() const { return outputHash; }
+
+private:
+    struct Connection {
+        std::deque<std::string> inbound;
+        uint64_t readyAtUs = 0; // когда дойдёт следующее сообщение
+        size_t consumed = 0;
+        size_t disconnectAfter = SIZE_MAX;
+        bool peerClosed = false;
+        bool serverClosed = false;
+        std::string output;
+    };
+
+    struct Task {
+        uint64_t id;
+        uint64_t wakeAtUs;
+        std::function<void()> body;
+        std::unique_ptr<char[]> stack;
+        ucontext_t context;
+        bool finished = false;
+    };
+
+    uint32_t nextRandom();
+    uint64_t deliveryDelay();
+    Connection* find(int connection);
+    // В задаче уступает планировщику до timeUs, вне задачи просто сдвигает часы
+    void waitUntil(uint64_t timeUs);
+    static void taskEntry(uint32_t low, uint32_t high);
+
+    std::unordered_map<int, Connection> connections;
+    int nextConnection = 1;
+    uint32_t seed;
+    TransportFaults faults;
+    bool captureOutput;
+    uint64_t clockUs = 0;
+    uint64_t sentBytes = 0;
+    uint64_t receivedBytes = 0;
+    uint64_t outputHash = 14695981039346656037ull;
+
+    std::vector<std::unique_ptr<Task>> tasks;
+    std::vector<std::unique_ptr<char[]>> freeStacks; // стеки завершённых задач
+    ucontext_t schedulerContext;
+    Task* current = nullptr;
+    uint64_t nextTaskId = 0;
+};